@@ -15,6 +15,36 @@ set_property(
 
 option( BUILD_SHARED_LIBS "Toggle whether to build Shared Libraries" ON )
 
+option(
+    CFRAME_HIDDEN_VISIBILITY
+    "Toggle to hide library symbols that are not explicitly exported"
+    ON
+)
+option(
+    CFRAME_EXPORT_SYMBOL_REPORT
+    "Toggle to report the number of exported symbols of shared libraries"
+    ON
+)
+
+set(
+   CFRAME_EXPORT_TEMPLATE_FILE
+   ${CMAKE_CURRENT_LIST_DIR}/detail/ExportTemplate.h.in
+   CACHE STRING "Export header template file"
+)
+set(
+   CFRAME_EXPORT_REPORT_SCRIPT
+   ${CMAKE_CURRENT_LIST_DIR}/detail/CFrameExportReport.cmake
+   CACHE INTERNAL "Script reporting exported symbols of shared libraries"
+)
+
+if ( NOT MSVC )
+  include( CheckCXXCompilerFlag )
+  check_cxx_compiler_flag(
+      -fno-semantic-interposition
+      CFRAME_HAVE_NO_SEMANTIC_INTERPOSITION
+  )
+endif()
+
 
 # -----------------------------------------------------------------------------
 # Forwards call to specified target function based on a list of argument
@@ -134,6 +164,13 @@ option(
 #   QT_QRCFILES         - a list of qt resource files
 #   NO_INSTALL          - Flag to indicate not to install the target in the standard location
 #   INSTALL_DEPS        - Flag to indicate to install dependencies of the target
+#   DEFAULT_VISIBILITY  - Flag to keep all symbols of a Library visible, even
+#                         when CFRAME_HIDDEN_VISIBILITY is ON
+#   EXPORT_HEADER       - path (relative to the generated include directory) of
+#                         the export header to generate for a Library, e.g.
+#                         mylib/mylibAPI.h
+#   EXPORT_MACRO        - name of the export macro defined in EXPORT_HEADER,
+#                         defaults to the upper case TARGET_NAME followed by _API
 #   HEADERS_INSTALL_DIR - the directory to install public headers to
 #   FILES_INSTALL_DIR   - the directory to install public files to
 #   BINARY_INSTALL_DIR  - the directory (prefix) where compiled targets will be installed to
@@ -147,6 +184,10 @@ option(
 #   CFRAME_INSTALL_LIB_DIR
 #   CFRAME_INSTALL_DEV_DIR
 #   CFRAME_INSTALL_DEPS     - Global flag to indicate whether to install dependencies
+#                             @see cframe_add_runtime_dependencies
+#   CFRAME_HIDDEN_VISIBILITY    - Global flag to hide non-exported library symbols
+#   CFRAME_EXPORT_SYMBOL_REPORT - Global flag to report exported symbol counts
+#   CFRAME_EXPORT_TEMPLATE_FILE - Template used to generate EXPORT_HEADER
 #
 # Global variables defined/modified:
 #
@@ -157,6 +198,20 @@ option(
 # @todo Allow building of both STATIC and SHARED libraries simultaneously
 # @todo Add specification of any number of FILTER_TAGS to be used for filtering.
 # @todo Add DEFINE_SYMBOL option(?)
+#
+# For example, generating the export header for a library:
+# @code
+# cframe_build_target(
+#     TARGET_NAME   mylib
+#     TYPE          Library
+#     EXPORT_HEADER mylib/mylibAPI.h
+#     EXPORT_MACRO  MYLIB_API
+#     ...
+# )
+# @endcode
+# will generate ${CMAKE_BINARY_DIR}/generated/include/mylib/mylibAPI.h, which
+# defines MYLIB_API (and MYLIB_API_LOCAL) for use in declarations, e.g.
+# class MYLIB_API MyClass, and which is installed along with HEADERS_PUBLIC.
 # -----------------------------------------------------------------------------
 function( cframe_build_target )
 
@@ -170,6 +225,7 @@ function( cframe_build_target )
   set( options
        NO_INSTALL
        INSTALL_DEPS
+       DEFAULT_VISIBILITY
   )
   set( oneValueArgs
        TARGET_NAME
@@ -181,6 +237,8 @@ function( cframe_build_target )
        HEADERS_INSTALL_DIR
        FILES_INSTALL_DIR
        BINARY_INSTALL_DIR
+       EXPORT_HEADER
+       EXPORT_MACRO
   )
   set( multiValueArgs
        INCLUDE_DIRS
@@ -233,6 +291,9 @@ function( cframe_build_target )
   cframe_message( MODE STATUS VERBOSITY 4 "HEADERS_INSTALL_DIR: ${ARGS_HEADERS_INSTALL_DIR}" )
   cframe_message( MODE STATUS VERBOSITY 4 "FILES_INSTALL_DIR:   ${ARGS_FILES_INSTALL_DIR}" )
   cframe_message( MODE STATUS VERBOSITY 4 "BINARY_INSTALL_DIR:  ${ARGS_BINARY_INSTALL_DIR}" )
+  cframe_message( MODE STATUS VERBOSITY 4 "DEFAULT_VISIBILITY:  ${ARGS_DEFAULT_VISIBILITY}" )
+  cframe_message( MODE STATUS VERBOSITY 4 "EXPORT_HEADER:       ${ARGS_EXPORT_HEADER}" )
+  cframe_message( MODE STATUS VERBOSITY 4 "EXPORT_MACRO:        ${ARGS_EXPORT_MACRO}" )
 
   # ------------------------------------
   # Preliminary Build checks and filters
@@ -423,21 +484,6 @@ function( cframe_build_target )
   # -----------------
   # Set up the Target
   # -----------------
-  set( ${ARGS_TARGET_NAME}_ALL_FILES
-      ${ARGS_HEADERS_PUBLIC}
-      ${ARGS_HEADERS_PRIVATE}
-      ${ARGS_FILES_PUBLIC}
-      ${ARGS_FILES_PRIVATE}
-      ${ARGS_SOURCES}
-      ${ARGS_QT_MOCFILES}
-      ${${ARGS_TARGET_NAME}_MOCSOURCES}
-      ${ARGS_QT_UIFILES}
-      ${${ARGS_TARGET_NAME}_UIHEADERS}
-      ${${ARGS_TARGET_NAME}_UISOURCES}
-      ${ARGS_QT_QRCFILES}
-      ${${ARGS_TARGET_NAME}_RESOURCES}
-  )
-
   set( ${ARGS_TARGET_NAME}_ALL_SOURCES
       ${ARGS_SOURCES}
       ${${ARGS_TARGET_NAME}_MOCSOURCES}
@@ -457,6 +503,54 @@ function( cframe_build_target )
     )
   endif() # Automatic conversion to "Custom" type
 
+  # ----------------------------------
+  # Generate the export header, if any
+  # ----------------------------------
+  if ( DEFINED ARGS_EXPORT_HEADER AND "${ARGS_TYPE}" STREQUAL "LIBRARY" )
+    if ( NOT DEFINED ARGS_EXPORT_MACRO )
+      string( TOUPPER "${ARGS_TARGET_NAME}_API" ARGS_EXPORT_MACRO )
+    endif()
+
+    # Must match the DEFINE_SYMBOL set on the target further below
+    if ( DEFINED ARGS_OUTPUT_NAME )
+      set( EXPORT_DEFINE_SYMBOL ${ARGS_OUTPUT_NAME}_EXPORTS )
+    else()
+      set( EXPORT_DEFINE_SYMBOL ${ARGS_TARGET_NAME}_EXPORTS )
+    endif()
+    set( EXPORT_STATIC_SYMBOL ${ARGS_TARGET_NAME}_STATIC )
+    set( EXPORT_TARGET ${ARGS_TARGET_NAME} )
+    set( EXPORT_MACRO ${ARGS_EXPORT_MACRO} )
+    string( MAKE_C_IDENTIFIER "${ARGS_EXPORT_HEADER}" EXPORT_GUARD )
+
+    set( EXPORT_INCLUDE_DIR ${CMAKE_BINARY_DIR}/generated/include )
+    set( GENERATED_EXPORT_HEADER ${EXPORT_INCLUDE_DIR}/${ARGS_EXPORT_HEADER} )
+    configure_file(
+        ${CFRAME_EXPORT_TEMPLATE_FILE}
+        ${GENERATED_EXPORT_HEADER}
+    )
+    # Generated header is installed with the rest of the public headers
+    list( APPEND ARGS_HEADERS_PUBLIC ${GENERATED_EXPORT_HEADER} )
+
+    cframe_message( MODE STATUS VERBOSITY 3
+        "CFrame: ${ARGS_TARGET_NAME} Generated Export Header: ${GENERATED_EXPORT_HEADER}"
+    )
+  endif() # Export header generation
+
+  set( ${ARGS_TARGET_NAME}_ALL_FILES
+      ${ARGS_HEADERS_PUBLIC}
+      ${ARGS_HEADERS_PRIVATE}
+      ${ARGS_FILES_PUBLIC}
+      ${ARGS_FILES_PRIVATE}
+      ${ARGS_SOURCES}
+      ${ARGS_QT_MOCFILES}
+      ${${ARGS_TARGET_NAME}_MOCSOURCES}
+      ${ARGS_QT_UIFILES}
+      ${${ARGS_TARGET_NAME}_UIHEADERS}
+      ${${ARGS_TARGET_NAME}_UISOURCES}
+      ${ARGS_QT_QRCFILES}
+      ${${ARGS_TARGET_NAME}_RESOURCES}
+  )
+
 
   if ( "${CFRAME_SOURCE_DISPLAY_MODE}" STREQUAL "FLAT" )
     source_group(
@@ -492,6 +586,11 @@ function( cframe_build_target )
     )
   endif()
 
+  # After the display modes, which would otherwise regroup it
+  if ( DEFINED GENERATED_EXPORT_HEADER )
+    source_group( \\generated FILES ${GENERATED_EXPORT_HEADER} )
+  endif()
+
   if ( "${ARGS_TYPE}" STREQUAL "LIBRARY" )
 
     # Only add the static definition for the library if a special link type isn't specified
@@ -514,6 +613,13 @@ function( cframe_build_target )
       )
     endif()
 
+    if ( DEFINED GENERATED_EXPORT_HEADER )
+      target_include_directories(
+          ${ARGS_TARGET_NAME} PUBLIC
+          $<BUILD_INTERFACE:${EXPORT_INCLUDE_DIR}>
+      )
+    endif()
+
 ##  elseif( ("${ARGS_TYPE}" STREQUAL "EXECUTABLE") OR
 ##          ("${ARGS_TYPE}" STREQUAL "TEST") )
   elseif( "${ARGS_TYPE}" STREQUAL "EXECUTABLE" )
@@ -700,6 +806,61 @@ function( cframe_build_target )
     endif()
   endif()
 
+  # hide symbols of libraries that are not explicitly exported
+  if ( CFRAME_HIDDEN_VISIBILITY AND
+       NOT ARGS_DEFAULT_VISIBILITY AND
+       "${ARGS_TYPE}" STREQUAL "LIBRARY" )
+    set_target_properties(
+        ${ARGS_TARGET_NAME} PROPERTIES
+        C_VISIBILITY_PRESET       hidden
+        CXX_VISIBILITY_PRESET     hidden
+        VISIBILITY_INLINES_HIDDEN ON
+    )
+    # Calls within the library may then be bound (and inlined) directly
+    # instead of going through the PLT
+    if ( CFRAME_HAVE_NO_SEMANTIC_INTERPOSITION )
+      target_compile_options(
+          ${ARGS_TARGET_NAME} PRIVATE
+          -fno-semantic-interposition
+      )
+    endif()
+
+    if ( DEFINED GENERATED_EXPORT_HEADER )
+      set( EXPORT_REPORT "exported with ${ARGS_EXPORT_MACRO}" )
+    else()
+      set( EXPORT_REPORT "no EXPORT_HEADER generated" )
+    endif()
+    cframe_message( MODE STATUS VERBOSITY 2
+        "CFrame: ${ARGS_TARGET_NAME}: hidden visibility, ${EXPORT_REPORT}"
+    )
+
+    # A handwritten export macro which expands to nothing outside of Windows
+    # would leave such a library without any exported symbols
+    if ( NOT DEFINED GENERATED_EXPORT_HEADER AND
+         "${LINK_TYPE}" STREQUAL "SHARED" )
+      cframe_message( MODE WARNING VERBOSITY 1
+          "CFrame: ${ARGS_TARGET_NAME}: shared library built with hidden symbol visibility but without EXPORT_HEADER, so only symbols explicitly marked visible are exported. Use EXPORT_HEADER to generate an export macro, or DEFAULT_VISIBILITY (or CFRAME_HIDDEN_VISIBILITY=OFF) to keep all symbols visible."
+      )
+    endif()
+  endif()
+
+  # report the number of exported symbols once shared libraries are linked
+  if ( CFRAME_EXPORT_SYMBOL_REPORT AND
+       CMAKE_NM AND
+       NOT WIN32 AND
+       "${ARGS_TYPE}" STREQUAL "LIBRARY" AND
+       "${LINK_TYPE}" STREQUAL "SHARED" )
+    add_custom_command(
+        TARGET ${ARGS_TARGET_NAME} POST_BUILD
+        COMMAND ${CMAKE_COMMAND}
+            -DTARGET_NAME=${ARGS_TARGET_NAME}
+            -DTARGET_FILE=$<TARGET_FILE:${ARGS_TARGET_NAME}>
+            -DNM=${CMAKE_NM}
+            -P ${CFRAME_EXPORT_REPORT_SCRIPT}
+        VERBATIM
+    )
+  endif()
+
   # install standard target artifacts
   if ( NOT ARGS_NO_INSTALL AND
        NOT "${ARGS_TYPE}" STREQUAL "CUSTOM" )
@@ -708,7 +869,6 @@ function( cframe_build_target )
       endif()
       install(
           TARGETS ${ARGS_TARGET_NAME}
-          RUNTIME_DEPENDENCY_SET ${ARGS_TARGET_NAME}_DEPS
           RUNTIME DESTINATION ${BINARY_INSTALL_PREFIX}${CFRAME_INSTALL_BIN_DIR} COMPONENT Runtime
           LIBRARY DESTINATION ${BINARY_INSTALL_PREFIX}${CFRAME_INSTALL_LIB_DIR} COMPONENT Runtime
           ARCHIVE DESTINATION ${BINARY_INSTALL_PREFIX}${CFRAME_INSTALL_DEV_DIR} COMPONENT Development
@@ -735,23 +895,11 @@ function( cframe_build_target )
   ## install dependencies
   if ( ARGS_INSTALL_DEPS AND CFRAME_INSTALL_DEPS AND
      NOT "${ARGS_TYPE}" STREQUAL "CUSTOM" )
-
-     #install(
-     #  TARGETS ${ARGS_TARGET_NAME}
-     #  RUNTIME_DEPENDENCY_SET ${ARGS_TARGET_NAME}_DEPS
-     #)
-     cframe_message( MODE STATUS VERBOSITY 2
-         "CFrame: Installing dependencies for target: ${ARGS_TARGET_NAME}: ${${ARGS_TARGET_NAME}_DEPS}"
-     )
-     install(
-         RUNTIME_DEPENDENCY_SET ${ARGS_TARGET_NAME}_DEPS
-         DESTINATION ${BINARY_INSTALL_PREFIX}${CFRAME_INSTALL_BIN_DIR}
-         PRE_EXCLUDE_REGEXES
-             "api-ms-.*" "ext-ms-.*"
-         POST_EXCLUDE_REGEXES
-             "libgcc_s-.*" "libstdc++-.*" "libwinpthread-.*"
-             ".*WINDOWS[\\\\/]system32.*" "msvcp.*\.dll" "vcruntime.*\.dll"
-         )
+    cframe_add_runtime_dependencies(
+        TARGET      ${ARGS_TARGET_NAME}
+        DESTINATION ${BINARY_INSTALL_PREFIX}${CFRAME_INSTALL_BIN_DIR}
+        COMPONENT   Runtime
+    )
   endif()
 
 endfunction() # cframe_build_target
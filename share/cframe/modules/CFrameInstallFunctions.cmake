@@ -70,3 +70,281 @@ function ( cframe_install_files )
   endforeach()
 
 endfunction() # cframe_install_files
+
+# -----------------------------------------------------------------------------
+# Settings for installing runtime dependencies of targets.
+# @see cframe_add_runtime_dependencies
+# -----------------------------------------------------------------------------
+set(
+    CFRAME_INSTALL_DEPS_DIRECTORIES ""
+    CACHE STRING "Additional directories to search for runtime dependencies"
+)
+set(
+    CFRAME_INSTALL_DEPS_PRE_EXCLUDE_REGEXES
+        "api-ms-.*" "ext-ms-.*"
+    CACHE STRING "Dependency names to exclude before resolving them"
+)
+set(
+    CFRAME_INSTALL_DEPS_POST_EXCLUDE_REGEXES
+        "libgcc_s-.*" "libstdc++-.*" "libwinpthread-.*"
+        ".*WINDOWS[\\\\/]system32.*" "msvcp.*\\.dll" "vcruntime.*\\.dll"
+    CACHE STRING "Resolved dependency paths to exclude from installation"
+)
+
+cmake_host_system_information(
+    RESULT CFRAME_INSTALL_DEPS_DEFAULT_JOBS
+    QUERY  NUMBER_OF_LOGICAL_CORES
+)
+set(
+    CFRAME_INSTALL_DEPS_JOBS ${CFRAME_INSTALL_DEPS_DEFAULT_JOBS}
+    CACHE STRING "Number of binaries to resolve runtime dependencies for in parallel"
+)
+
+set(
+    CFRAME_INSTALL_DEPS_CACHE_DIR ${CMAKE_BINARY_DIR}/CFrameRuntimeDeps
+    CACHE PATH "Directory for caching resolved runtime dependencies"
+)
+
+set(
+    CFRAME_INSTALL_DEPS_SCRIPT
+    ${CMAKE_CURRENT_LIST_DIR}/detail/CFrameInstallRuntimeDeps.cmake
+    CACHE INTERNAL "Install-time script for installing runtime dependencies"
+)
+set(
+    CFRAME_RESOLVE_DEPS_SCRIPT
+    ${CMAKE_CURRENT_LIST_DIR}/detail/CFrameResolveRuntimeDeps.cmake
+    CACHE INTERNAL "Script for resolving runtime dependencies of one binary"
+)
+
+# -----------------------------------------------------------------------------
+# Adds the runtime dependencies of a target to be installed. Rather than each
+# target having its own RUNTIME_DEPENDENCY_SET, targets are collected into one
+# merged set per install COMPONENT (and DESTINATION), which is installed by
+# cframe_install_runtime_dependencies once all targets are known.
+#
+# At install time the dependencies of each binary are cached (keyed by the
+# hash of its contents, and checked against the size and modification time of
+# each resolved dependency) so that only changed binaries are re-scanned, the
+# scans are run in parallel, and libraries needed in several destinations are
+# hardlinked rather than copied again. Libraries built by the project are
+# left to their own install rules.
+#
+# TARGET      The target whose runtime dependencies should be installed.
+# DESTINATION The directory to install the dependencies to.
+# COMPONENT   The install component. Defaults to Runtime.
+#
+# @see cframe_build_target
+# -----------------------------------------------------------------------------
+function( cframe_add_runtime_dependencies )
+
+  cframe_message( MODE STATUS VERBOSITY 3
+      "CFrame: FUNCTION: cframe_add_runtime_dependencies"
+  )
+
+  # -----------------------------------
+  # Set up and parse multiple arguments
+  # -----------------------------------
+  set( options
+  )
+  set( oneValueArgs
+       TARGET
+       DESTINATION
+       COMPONENT
+  )
+  set( multiValueArgs
+  )
+
+  cmake_parse_arguments(
+      ARGS
+      "${options}"
+      "${oneValueArgs}"
+      "${multiValueArgs}"
+      ${ARGN}
+  )
+
+  if ( NOT ARGS_COMPONENT )
+    set( ARGS_COMPONENT Runtime )
+  endif()
+
+  # Only binaries loaded at runtime have dependencies to resolve
+  get_target_property( type ${ARGS_TARGET} TYPE )
+  if ( "${type}" STREQUAL "EXECUTABLE" )
+    set( binaryType EXECUTABLES )
+  elseif ( "${type}" STREQUAL "SHARED_LIBRARY" )
+    set( binaryType LIBRARIES )
+  elseif ( "${type}" STREQUAL "MODULE_LIBRARY" )
+    set( binaryType MODULES )
+  else()
+    return()
+  endif()
+
+  cframe_message( MODE STATUS VERBOSITY 2
+      "CFrame: Installing dependencies for target: ${ARGS_TARGET}"
+  )
+
+  string(
+      MAKE_C_IDENTIFIER "${ARGS_COMPONENT}_${ARGS_DESTINATION}" setId
+  )
+
+  get_property( sets GLOBAL PROPERTY CFRAME_RUNTIME_DEPS_SETS )
+  if ( NOT "${setId}" IN_LIST sets )
+    set_property( GLOBAL APPEND PROPERTY CFRAME_RUNTIME_DEPS_SETS ${setId} )
+    set_property(
+        GLOBAL PROPERTY CFRAME_RUNTIME_DEPS_${setId}_COMPONENT ${ARGS_COMPONENT}
+    )
+    set_property(
+        GLOBAL PROPERTY CFRAME_RUNTIME_DEPS_${setId}_DESTINATION ${ARGS_DESTINATION}
+    )
+  endif()
+  set_property(
+      GLOBAL APPEND PROPERTY CFRAME_RUNTIME_DEPS_${setId}_${binaryType} ${ARGS_TARGET}
+  )
+
+  # Install the merged sets once, after all targets have been added
+  get_property( deferred GLOBAL PROPERTY CFRAME_RUNTIME_DEPS_DEFERRED )
+  if ( NOT deferred )
+    set_property( GLOBAL PROPERTY CFRAME_RUNTIME_DEPS_DEFERRED TRUE )
+    cmake_language(
+        DEFER DIRECTORY ${CMAKE_SOURCE_DIR}
+        CALL cframe_install_runtime_dependencies
+    )
+  endif()
+
+endfunction() # cframe_add_runtime_dependencies
+
+# -----------------------------------------------------------------------------
+# Collects the executables and shared/module libraries built in a directory
+# and its subdirectories.
+#
+# DIRECTORY The directory to start from.
+# OUTPUT    Variable receiving the list of targets.
+# -----------------------------------------------------------------------------
+function( cframe_collect_binary_targets )
+
+  set( options
+  )
+  set( oneValueArgs
+       DIRECTORY
+       OUTPUT
+  )
+  set( multiValueArgs
+  )
+
+  cmake_parse_arguments(
+      ARGS
+      "${options}"
+      "${oneValueArgs}"
+      "${multiValueArgs}"
+      ${ARGN}
+  )
+
+  set( binaryTargets )
+  get_property( targets DIRECTORY ${ARGS_DIRECTORY} PROPERTY BUILDSYSTEM_TARGETS )
+  foreach( target ${targets} )
+    get_target_property( type ${target} TYPE )
+    if ( "${type}" STREQUAL "EXECUTABLE" OR
+         "${type}" STREQUAL "SHARED_LIBRARY" OR
+         "${type}" STREQUAL "MODULE_LIBRARY" )
+      list( APPEND binaryTargets ${target} )
+    endif()
+  endforeach()
+
+  get_property( subdirs DIRECTORY ${ARGS_DIRECTORY} PROPERTY SUBDIRECTORIES )
+  foreach( subdir ${subdirs} )
+    cframe_collect_binary_targets( DIRECTORY ${subdir} OUTPUT subdirTargets )
+    list( APPEND binaryTargets ${subdirTargets} )
+  endforeach()
+
+  set( ${ARGS_OUTPUT} ${binaryTargets} PARENT_SCOPE )
+
+endfunction() # cframe_collect_binary_targets
+
+# -----------------------------------------------------------------------------
+# Creates one install rule per install component for the runtime dependency
+# sets collected by cframe_add_runtime_dependencies. Called automatically at
+# the end of the configuration of the top-level directory.
+#
+# @see cframe_add_runtime_dependencies
+# -----------------------------------------------------------------------------
+function( cframe_install_runtime_dependencies )
+
+  cframe_message( MODE STATUS VERBOSITY 3
+      "CFrame: FUNCTION: cframe_install_runtime_dependencies"
+  )
+
+  # Settings are shared by the install script and the parallel resolvers
+  set( settingsFile ${CMAKE_BINARY_DIR}/CFrameRuntimeDepsSettings.cmake )
+  set( settings "# Generated by cframe_install_runtime_dependencies\n" )
+  foreach( setting
+      DIRECTORIES PRE_EXCLUDE_REGEXES POST_EXCLUDE_REGEXES )
+    string( APPEND settings "set( CFRAME_DEPS_${setting}\n" )
+    foreach( value ${CFRAME_INSTALL_DEPS_${setting}} )
+      string( APPEND settings "    [==[${value}]==]\n" )
+    endforeach()
+    string( APPEND settings ")\n" )
+  endforeach()
+  file( CONFIGURE OUTPUT ${settingsFile} CONTENT "${settings}" @ONLY )
+
+  get_property( sets GLOBAL PROPERTY CFRAME_RUNTIME_DEPS_SETS )
+
+  # Libraries built by the project are never installed as dependencies, also
+  # when they are not part of any set
+  cframe_collect_binary_targets(
+      DIRECTORY ${CMAKE_SOURCE_DIR}
+      OUTPUT    projectTargets
+  )
+  set( projectFiles )
+  foreach( target ${projectTargets} )
+    list( APPEND projectFiles "$<TARGET_FILE:${target}>" )
+  endforeach()
+
+  set( components )
+  foreach( setId ${sets} )
+    get_property(
+        component GLOBAL PROPERTY CFRAME_RUNTIME_DEPS_${setId}_COMPONENT
+    )
+    list( APPEND components ${component} )
+    list( APPEND ${component}_SETS ${setId} )
+  endforeach()
+  list( REMOVE_DUPLICATES components )
+
+  foreach( component ${components} )
+
+    set( code "set( CFRAME_DEPS_SETS ${${component}_SETS} )\n" )
+    foreach( setId ${${component}_SETS} )
+      get_property(
+          destination GLOBAL PROPERTY CFRAME_RUNTIME_DEPS_${setId}_DESTINATION
+      )
+      string(
+          APPEND code
+          "set( CFRAME_DEPS_${setId}_DESTINATION \"${destination}\" )\n"
+      )
+      foreach( binaryType EXECUTABLES LIBRARIES MODULES )
+        get_property(
+            targets GLOBAL PROPERTY CFRAME_RUNTIME_DEPS_${setId}_${binaryType}
+        )
+        set( files )
+        foreach( target ${targets} )
+          list( APPEND files "$<TARGET_FILE:${target}>" )
+        endforeach()
+        string(
+            APPEND code
+            "set( CFRAME_DEPS_${setId}_${binaryType} \"${files}\" )\n"
+        )
+      endforeach()
+    endforeach()
+
+    string( APPEND code
+        "set( CFRAME_DEPS_PROJECT_FILES \"${projectFiles}\" )\n"
+        "set( CFRAME_DEPS_CACHE_DIR \"${CFRAME_INSTALL_DEPS_CACHE_DIR}\" )\n"
+        "set( CFRAME_DEPS_SETTINGS_FILE \"${settingsFile}\" )\n"
+        "set( CFRAME_DEPS_RESOLVE_SCRIPT \"${CFRAME_RESOLVE_DEPS_SCRIPT}\" )\n"
+        "set( CFRAME_DEPS_JOBS ${CFRAME_INSTALL_DEPS_JOBS} )\n"
+        "include( \"${CFRAME_INSTALL_DEPS_SCRIPT}\" )\n"
+    )
+
+    install( CODE "${code}" COMPONENT ${component} )
+
+  endforeach() # components
+
+endfunction() # cframe_install_runtime_dependencies
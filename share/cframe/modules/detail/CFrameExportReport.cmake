@@ -0,0 +1,32 @@
+# -----------------------------------------------------------------------------
+#
+# Script (run with cmake -P) that reports the number of symbols exported from
+# the dynamic symbol table of a shared library.
+#
+# Variables expected to be defined (with -D):
+#   TARGET_NAME - name of the target being reported on
+#   TARGET_FILE - path to the built shared library
+#   NM          - path to the nm tool
+#
+# @see cframe_build_target
+# -----------------------------------------------------------------------------
+
+if ( NOT EXISTS "${TARGET_FILE}" OR NOT NM )
+  return()
+endif()
+
+execute_process(
+    COMMAND ${NM} -D --defined-only "${TARGET_FILE}"
+    OUTPUT_VARIABLE symbols
+    RESULT_VARIABLE result
+    ERROR_QUIET
+)
+if ( NOT result EQUAL 0 )
+  message( STATUS "CFrame: ${TARGET_NAME}: unable to read dynamic symbols" )
+  return()
+endif()
+
+string( REGEX MATCHALL "\n[0-9a-fA-F]* [^\n]" entries "\n${symbols}" )
+list( LENGTH entries count )
+
+message( STATUS "CFrame: ${TARGET_NAME}: ${count} exported symbols" )
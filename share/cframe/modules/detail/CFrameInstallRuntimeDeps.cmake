@@ -0,0 +1,211 @@
+# -----------------------------------------------------------------------------
+#
+# Install-time script installing the merged runtime dependency sets of one
+# install component. Included from the install(CODE) generated by
+# cframe_install_runtime_dependencies, which defines:
+#
+#   CFRAME_DEPS_SETS                   - the ids of the sets to install
+#   CFRAME_DEPS_<id>_DESTINATION       - the install directory of a set
+#   CFRAME_DEPS_<id>_EXECUTABLES       - the executables of a set
+#   CFRAME_DEPS_<id>_LIBRARIES         - the shared libraries of a set
+#   CFRAME_DEPS_<id>_MODULES           - the modules of a set
+#   CFRAME_DEPS_PROJECT_FILES          - all binaries built by the project
+#   CFRAME_DEPS_CACHE_DIR              - directory of resolved dependencies
+#   CFRAME_DEPS_SETTINGS_FILE          - search/exclude settings
+#   CFRAME_DEPS_RESOLVE_SCRIPT         - script resolving a single binary
+#   CFRAME_DEPS_JOBS                   - number of binaries to resolve at once
+#
+# @see cframe_add_runtime_dependencies
+# -----------------------------------------------------------------------------
+
+file( SHA256 ${CFRAME_DEPS_SETTINGS_FILE} settingsHash )
+
+# -----------------------------------------------------------------------------
+# Checks whether a cache file is still valid: the resolved dependencies are
+# transitive, so they may change even though the binary itself did not, e.g.
+# when a library of the project it links to gains a dependency.
+# -----------------------------------------------------------------------------
+function( cframe_deps_cache_valid cacheFile outVar )
+  set( ${outVar} FALSE PARENT_SCOPE )
+  if ( NOT EXISTS ${cacheFile} )
+    return()
+  endif()
+
+  unset( STAMPS )
+  include( ${cacheFile} )
+  if ( NOT DEFINED STAMPS )
+    return()
+  endif()
+
+  list( LENGTH RESOLVED count )
+  list( LENGTH STAMPS stampCount )
+  if ( NOT count EQUAL stampCount )
+    return()
+  endif()
+
+  if ( count GREATER 0 )
+    math( EXPR last "${count} - 1" )
+    foreach( index RANGE ${last} )
+      list( GET RESOLVED ${index} dependency )
+      list( GET STAMPS ${index} stamp )
+      if ( NOT EXISTS ${dependency} )
+        return()
+      endif()
+      file( SIZE ${dependency} size )
+      file( TIMESTAMP ${dependency} modified "%s" UTC )
+      if ( NOT "${size}:${modified}" STREQUAL "${stamp}" )
+        return()
+      endif()
+    endforeach()
+  endif()
+
+  set( ${outVar} TRUE PARENT_SCOPE )
+endfunction() # cframe_deps_cache_valid
+
+# Binaries built by the project are installed by their own install rules
+set( projectRealPaths )
+foreach( projectFile ${CFRAME_DEPS_PROJECT_FILES} )
+  get_filename_component( realPath ${projectFile} REALPATH )
+  list( APPEND projectRealPaths ${realPath} )
+endforeach()
+
+# ----------------------------------------------------------------------
+# Look up the cached dependencies of each binary by content hash, and
+# check them against the current state of the resolved dependencies.
+# Identical binaries (e.g. installed to several destinations) share a
+# cache file, which is resolved only once.
+# ----------------------------------------------------------------------
+set( pendingCacheFiles )
+set( pendingCommands )
+foreach( setId ${CFRAME_DEPS_SETS} )
+  foreach( binaryType EXECUTABLES LIBRARIES MODULES )
+    foreach( binary ${CFRAME_DEPS_${setId}_${binaryType}} )
+      file( SHA256 ${binary} binaryHash )
+      string( SHA256 key "${binaryType};${binaryHash};${settingsHash}" )
+      set( cacheFile ${CFRAME_DEPS_CACHE_DIR}/${key}.deps )
+      set( CACHE_FILE_${binary} ${cacheFile} )
+
+      list( FIND pendingCacheFiles ${cacheFile} index )
+      if ( index GREATER -1 )
+        continue()
+      endif()
+
+      cframe_deps_cache_valid( ${cacheFile} valid )
+      if ( NOT valid )
+        file( REMOVE ${cacheFile} )
+        list( APPEND pendingCacheFiles ${cacheFile} )
+        list( APPEND pendingCommands
+            COMMAND ${CMAKE_COMMAND}
+                -DSETTINGS_FILE=${CFRAME_DEPS_SETTINGS_FILE}
+                -DBINARY=${binary}
+                -DBINARY_TYPE=${binaryType}
+                -DCACHE_FILE=${cacheFile}
+                -P ${CFRAME_DEPS_RESOLVE_SCRIPT}
+        )
+      endif()
+    endforeach()
+  endforeach()
+endforeach()
+
+# ----------------------------------------------------------------------
+# Resolve changed binaries. All COMMANDs of a single execute_process()
+# run concurrently, so issue them in batches of CFRAME_DEPS_JOBS.
+# ----------------------------------------------------------------------
+list( LENGTH pendingCacheFiles pendingCount )
+if ( pendingCount GREATER 0 )
+  message( STATUS
+      "Resolving runtime dependencies of ${pendingCount} changed binaries"
+  )
+endif()
+
+if ( NOT CFRAME_DEPS_JOBS GREATER 0 )
+  set( CFRAME_DEPS_JOBS 1 )
+endif()
+
+while ( pendingCommands )
+  set( batch )
+  set( jobs 0 )
+  while ( pendingCommands AND jobs LESS CFRAME_DEPS_JOBS )
+    # Each command is COMMAND, cmake, 4 -D arguments, -P and the script
+    list( SUBLIST pendingCommands 0 8 command )
+    list( REMOVE_AT pendingCommands 0 1 2 3 4 5 6 7 )
+    list( APPEND batch ${command} )
+    math( EXPR jobs "${jobs} + 1" )
+  endwhile()
+
+  execute_process( ${batch} OUTPUT_QUIET )
+endwhile()
+
+# -----------------------------------------------------
+# Install each set, hardlinking repeated shared objects
+# -----------------------------------------------------
+foreach( setId ${CFRAME_DEPS_SETS} )
+  set( destination ${CFRAME_DEPS_${setId}_DESTINATION} )
+  if ( NOT IS_ABSOLUTE "${destination}" )
+    set( destination ${CMAKE_INSTALL_PREFIX}/${destination} )
+  endif()
+
+  set( setBinaries
+      ${CFRAME_DEPS_${setId}_EXECUTABLES}
+      ${CFRAME_DEPS_${setId}_LIBRARIES}
+      ${CFRAME_DEPS_${setId}_MODULES}
+  )
+
+  set( dependencies )
+  foreach( binary ${setBinaries} )
+    if ( NOT EXISTS ${CACHE_FILE_${binary}} )
+      message( WARNING
+          "Unable to resolve runtime dependencies of ${binary}"
+      )
+      continue()
+    endif()
+
+    include( ${CACHE_FILE_${binary}} )
+    list( APPEND dependencies ${RESOLVED} )
+    foreach( unresolved ${UNRESOLVED} )
+      message( WARNING
+          "Unresolved runtime dependency of ${binary}: ${unresolved}"
+      )
+    endforeach()
+  endforeach()
+  list( REMOVE_DUPLICATES dependencies )
+
+  foreach( dependency ${dependencies} )
+    get_filename_component( name ${dependency} NAME )
+    get_filename_component( realPath ${dependency} REALPATH )
+    list( FIND projectRealPaths ${realPath} index )
+    if ( index GREATER -1 )
+      continue()
+    endif()
+
+    string( SHA256 realKey "${realPath}" )
+    # Note: file(INSTALL) prepends DESTDIR itself, file(CREATE_LINK) does not
+    set( destFile $ENV{DESTDIR}${destination}/${name} )
+
+    if ( DEFINED INSTALLED_${realKey} )
+      if ( "${INSTALLED_${realKey}}" STREQUAL "${destFile}" )
+        continue()
+      endif()
+
+      message( STATUS "Linking: ${destFile}" )
+      file( MAKE_DIRECTORY $ENV{DESTDIR}${destination} )
+      file( REMOVE ${destFile} )
+      file(
+          CREATE_LINK ${INSTALLED_${realKey}} ${destFile}
+          COPY_ON_ERROR
+      )
+    else()
+      file(
+          INSTALL
+          DESTINATION ${destination}
+          TYPE SHARED_LIBRARY
+          FOLLOW_SYMLINK_CHAIN
+          FILES ${dependency}
+      )
+
+      get_filename_component( realName ${realPath} NAME )
+      set( INSTALLED_${realKey} $ENV{DESTDIR}${destination}/${realName} )
+    endif()
+  endforeach() # dependencies
+
+endforeach() # CFRAME_DEPS_SETS
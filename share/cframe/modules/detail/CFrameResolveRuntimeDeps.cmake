@@ -0,0 +1,47 @@
+# -----------------------------------------------------------------------------
+#
+# Script (run with cmake -P) that resolves the runtime dependencies of a
+# single binary and writes them, with a size/modification time stamp of each
+# resolved dependency, to a cache file.
+#
+# Variables expected to be defined (with -D):
+#   SETTINGS_FILE - file defining the CFRAME_DEPS_* search/exclude settings
+#   BINARY        - path to the binary to resolve
+#   BINARY_TYPE   - EXECUTABLES, LIBRARIES or MODULES
+#   CACHE_FILE    - the file to write the resolved dependencies to
+#
+# @see cframe_add_runtime_dependencies
+# -----------------------------------------------------------------------------
+
+include( ${SETTINGS_FILE} )
+
+file(
+    GET_RUNTIME_DEPENDENCIES
+    ${BINARY_TYPE} ${BINARY}
+    RESOLVED_DEPENDENCIES_VAR   resolved
+    UNRESOLVED_DEPENDENCIES_VAR unresolved
+    DIRECTORIES                 ${CFRAME_DEPS_DIRECTORIES}
+    PRE_EXCLUDE_REGEXES         ${CFRAME_DEPS_PRE_EXCLUDE_REGEXES}
+    POST_EXCLUDE_REGEXES        ${CFRAME_DEPS_POST_EXCLUDE_REGEXES}
+)
+
+# Stamp every resolved dependency, so a cached entry can be checked against
+# changes of the dependencies (e.g. a library of the project gaining another
+# dependency, or a system upgrade replacing a library). Libraries built by the
+# project are among them, as they are only filtered out when installing.
+set( stamps )
+foreach( dependency ${resolved} )
+  file( SIZE ${dependency} size )
+  file( TIMESTAMP ${dependency} modified "%s" UTC )
+  list( APPEND stamps "${size}:${modified}" )
+endforeach()
+
+# Write to a temporary file first so a partially written cache file is never
+# picked up by a later install
+file(
+    WRITE ${CACHE_FILE}.tmp
+    "set( RESOLVED \"${resolved}\" )\n"
+    "set( UNRESOLVED \"${unresolved}\" )\n"
+    "set( STAMPS \"${stamps}\" )\n"
+)
+file( RENAME ${CACHE_FILE}.tmp ${CACHE_FILE} )
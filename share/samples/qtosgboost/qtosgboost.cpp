@@ -6,6 +6,7 @@
 
 // Qt Includes
 #include <QtWidgets/QAction>
+#include <QtWidgets/QActionGroup>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QFileDialog>
 #include <QtWidgets/QMenu>
@@ -14,11 +15,20 @@
 
 #include <QtGui/QResizeEvent>
 
+#include <QtCore/QMetaObject>
+#include <QtCore/QStandardPaths>
 #include <QtCore/QTimer>
 
 // OpenSceneGraph Includes
 // NOTE: Make sure to include GraphicsWindowX11 **AFTER** Qt on Linux
+#include <osg/Drawable>
+#include <osg/Geometry>
+#include <osg/KdTree>
+#include <osg/Version>
+#include <osgDB/FileNameUtils>
 #include <osgDB/ReadFile>
+#include <osgDB/Registry>
+#include <osgDB/WriteFile>
 #include <osgGA/StateSetManipulator>
 #include <osgGA/TrackballManipulator>
 
@@ -38,13 +48,633 @@ typedef Window                                   WindowHandle;
 typedef osgViewer::GraphicsWindowX11::WindowData WindowData;
 #endif
 
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <boost/date_time/c_local_time_adjustor.hpp>
 #include <boost/date_time/local_time_adjustor.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <streambuf>
+#include <thread>
+
 namespace qtosgboost {
 
+using Clock = std::chrono::steady_clock;
+
+/**
+ * Interval for checking whether a frame is needed in RenderMode::OnDemand.
+ * Checking only polls for pending window events, so is nearly free.
+ */
+constexpr int kOnDemandPollInterval = 10; // ms
+
+/** Part of the model cache key, increment when changing what is cached. */
+constexpr int kModelCacheVersion = 2;
+
+/** State of a single model load, shared between the GUI and a worker. */
+struct QOSGWindow::ModelLoad
+{
+  LoadId            id;
+  std::string       filename;
+  std::string       timestamp;
+  ModelOptimization optimization;
+
+  std::atomic<bool>   cancelled{ false };
+  std::atomic<bool>   finished{ false };
+  std::atomic<double> progress{ 0.0 };
+
+  // Written by the worker before finished is set
+  osg::ref_ptr<osg::Node> model;
+  LoadMetrics             metrics;
+
+  // Only accessed on the GUI thread
+  Clock::time_point queued;
+  double            reportedProgress = -1.0;
+}; // struct QOSGWindow::ModelLoad
+
+namespace {
+
+std::string
+utcTimestamp()
+{
+  using boost::gregorian::day_clock;
+  using boost::posix_time::ptime;
+  using boost::posix_time::second_clock;
+  using boost::posix_time::to_simple_string;
+
+  ptime todayUtc( day_clock::universal_day(),
+                  second_clock::universal_time().time_of_day() );
+  return to_simple_string( todayUtc );
+} // utcTimestamp
+
+double
+secondsSince( Clock::time_point start )
+{
+  return std::chrono::duration<double>( Clock::now() - start ).count();
+} // secondsSince
+
+/**
+ * Stream buffer which records the progress of reading the underlying file
+ * and stops supplying data once its load is cancelled.
+ */
+class ProgressStreamBuf : public std::streambuf
+{
+public:
+  ProgressStreamBuf( std::streambuf *          source,
+                     std::uintmax_t            size,
+                     std::atomic<double> &     progress,
+                     std::atomic<bool> const & cancelled )
+      : mSource( source )
+      , mSize( size )
+      , mRead( 0 )
+      , mProgress( progress )
+      , mCancelled( cancelled )
+  {
+  }
+
+private:
+  int_type underflow() override
+  {
+    if ( mCancelled ) {
+      return traits_type::eof();
+    }
+
+    auto count = mSource->sgetn( mBuffer, sizeof( mBuffer ) );
+    if ( count <= 0 ) {
+      return traits_type::eof();
+    }
+
+    mRead += count;
+    if ( mSize > 0 ) {
+      mProgress = std::min( 1.0, double( mRead ) / double( mSize ) );
+    }
+
+    setg( mBuffer, mBuffer, mBuffer + count );
+    return traits_type::to_int_type( *gptr() );
+  }
+
+  // Plugins may probe the header and rewind, so seeking is forwarded to the
+  // source, discarding the buffered data
+  pos_type seekoff( off_type                off,
+                    std::ios_base::seekdir  dir,
+                    std::ios_base::openmode which ) override
+  {
+    // The source is ahead of the reader by the unread part of the buffer
+    off_type unread = egptr() - gptr();
+    if ( dir == std::ios_base::cur && off == 0 ) {
+      auto pos = mSource->pubseekoff( 0, dir, which );
+      return pos == pos_type( off_type( -1 ) ) ? pos : pos - unread;
+    }
+    if ( dir == std::ios_base::cur ) {
+      off -= unread;
+    }
+
+    setg( mBuffer, mBuffer, mBuffer );
+    return seeked( mSource->pubseekoff( off, dir, which ) );
+  }
+
+  pos_type seekpos( pos_type pos, std::ios_base::openmode which ) override
+  {
+    setg( mBuffer, mBuffer, mBuffer );
+    return seeked( mSource->pubseekpos( pos, which ) );
+  }
+
+  pos_type seeked( pos_type pos )
+  {
+    if ( pos != pos_type( off_type( -1 ) ) ) {
+      mRead = std::streamoff( pos );
+    }
+    return pos;
+  }
+
+  std::streambuf *          mSource;
+  std::uintmax_t            mSize;
+  std::uintmax_t            mRead;
+  std::atomic<double> &     mProgress;
+  std::atomic<bool> const & mCancelled;
+  char                      mBuffer[64 * 1024];
+
+}; // class ProgressStreamBuf
+
+/**
+ * Records the files plugins look up while reading a model (textures, material
+ * libraries, external references, ...), so a cached model can be checked
+ * against changes of these as well.
+ */
+class RecordingFindFileCallback : public osgDB::FindFileCallback
+{
+public:
+  std::string findDataFile( std::string const &    filename,
+                            osgDB::Options const * options,
+                            osgDB::CaseSensitivity caseSensitivity ) override
+  {
+    auto found = osgDB::FindFileCallback::findDataFile(
+        filename, options, caseSensitivity );
+    if ( !found.empty() ) {
+      std::lock_guard<std::mutex> lock( mMutex );
+      mFiles.insert( found );
+    }
+    return found;
+  }
+
+  std::set<std::string> files() const
+  {
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mFiles;
+  }
+
+private:
+  mutable std::mutex    mMutex;
+  std::set<std::string> mFiles;
+
+}; // class RecordingFindFileCallback
+
+/** Reader options which let plugins resolve files referenced by the model. */
+osg::ref_ptr<osgDB::Options>
+modelReadOptions( std::string const & filename )
+{
+  auto registry = osgDB::Registry::instance();
+
+  osg::ref_ptr<osgDB::Options> options =
+      registry->getOptions() ? registry->getOptions()->cloneOptions()
+                             : new osgDB::Options;
+  options->getDatabasePathList().push_front( osgDB::getFilePath( filename ) );
+  return options;
+} // modelReadOptions
+
+/**
+ * Reads the model through a ProgressStreamBuf if its plugin supports reading
+ * from streams, otherwise reads it directly from file with osgDB.
+ *
+ * The stream path only asks the first plugin for the extension, and skips the
+ * Registry's ReadFileCallback and archive handling. So anything but a loaded
+ * node or a plugin reporting a broken file (plugins without stream support
+ * report NOT_IMPLEMENTED or FILE_NOT_HANDLED) is read again directly, which
+ * does all of these, only without progress and cancellation.
+ */
+osg::ref_ptr<osg::Node>
+readModel( std::string const &       filename,
+           osgDB::Options const *    options,
+           std::uintmax_t            size,
+           std::atomic<double> &     progress,
+           std::atomic<bool> const & cancelled )
+{
+  auto registry = osgDB::Registry::instance();
+  auto rw       = registry->getReaderWriterForExtension(
+      osgDB::getLowerCaseFileExtension( filename ) );
+
+  if ( rw ) {
+    std::ifstream file( filename, std::ios::in | std::ios::binary );
+    if ( file ) {
+      ProgressStreamBuf buffer( file.rdbuf(), size, progress, cancelled );
+      std::istream      stream( &buffer );
+
+      auto result = rw->readNode( stream, options );
+      if ( cancelled ) {
+        return nullptr;
+      }
+
+      if ( result.validNode() ) {
+        progress = 1.0;
+        return result.getNode();
+      }
+      if ( result.status() ==
+           osgDB::ReaderWriter::ReadResult::ERROR_IN_READING_FILE ) {
+        progress = 1.0;
+        return nullptr;
+      }
+    }
+  }
+
+  auto model = osgDB::readRefNodeFile( filename, options );
+  progress   = 1.0;
+  return model;
+} // readModel
+
+/** Size and modification time of a file, empty if it does not exist. */
+std::string
+fileStamp( boost::filesystem::path const & path )
+{
+  boost::system::error_code error;
+  auto size = boost::filesystem::file_size( path, error );
+  if ( error ) {
+    return std::string();
+  }
+  auto modified = boost::filesystem::last_write_time( path, error );
+  if ( error ) {
+    return std::string();
+  }
+
+  std::ostringstream stamp;
+  stamp << size << ':' << modified;
+  return stamp.str();
+} // fileStamp
+
+/**
+ * Path of the cached, optimized model for the specified model file, or an
+ * empty path if the model file can not be identified. The name is a stable
+ * (FNV-1a) hash of everything which affects the cached model, including the
+ * reader option string, which changes how plugins parse the model. Files the
+ * model references are checked separately, see modelCacheValid.
+ */
+boost::filesystem::path
+modelCachePath( std::string const &       filename,
+                osgDB::Options const &    options,
+                ModelOptimization const & optimization )
+{
+  namespace fs = boost::filesystem;
+
+  boost::system::error_code error;
+  auto                      path = fs::canonical( filename, error );
+  if ( error ) {
+    return fs::path();
+  }
+  auto stamp = fileStamp( path );
+  if ( stamp.empty() ) {
+    return fs::path();
+  }
+
+  std::ostringstream key;
+  key << kModelCacheVersion << '\n'
+      << osgGetVersion() << '\n'
+      << path.string() << '\n'
+      << stamp << '\n'
+      << options.getOptionString() << '\n'
+      << optimization.optimizerOptions;
+
+  std::uint64_t hash = 14695981039346656037ull;
+  for ( unsigned char c : key.str() ) {
+    hash = ( hash ^ c ) * 1099511628211ull;
+  }
+
+  std::ostringstream name;
+  name << path.stem().string() << '-' << std::hex << std::setw( 16 )
+       << std::setfill( '0' ) << hash << ".osgb";
+  return fs::path( optimization.cacheDirectory ) / name.str();
+} // modelCachePath
+
+/** The file listing the files a cached model was made from. */
+boost::filesystem::path
+modelCacheDependenciesPath( boost::filesystem::path cachePath )
+{
+  return cachePath.replace_extension( ".deps" );
+} // modelCacheDependenciesPath
+
+/**
+ * Whether the cached model exists and none of the files it was made from
+ * changed. Each line of its dependencies file is the stamp and path of one
+ * such file.
+ */
+bool
+modelCacheValid( boost::filesystem::path const & cachePath )
+{
+  if ( !boost::filesystem::exists( cachePath ) ) {
+    return false;
+  }
+
+  auto          dependenciesPath = modelCacheDependenciesPath( cachePath );
+  std::ifstream dependencies( dependenciesPath.string() );
+  if ( !dependencies ) {
+    return false;
+  }
+
+  std::string line;
+  while ( std::getline( dependencies, line ) ) {
+    auto separator = line.find( ' ' );
+    if ( separator == std::string::npos ||
+         line.substr( 0, separator ) !=
+             fileStamp( line.substr( separator + 1 ) ) ) {
+      return false;
+    }
+  }
+  return true;
+} // modelCacheValid
+
+/** Writes a file under a temporary name first, then renames it into place. */
+template <typename Write>
+bool
+writeAtomically( boost::filesystem::path const & path, Write write )
+{
+  namespace fs = boost::filesystem;
+
+  // Keep the extension, plugins are chosen by it
+  boost::system::error_code error;
+  auto temporaryPath = fs::unique_path(
+      path.parent_path() / ( "%%%%-%%%%-%%%%-%%%%.tmp" +
+                             path.extension().string() ),
+      error );
+  if ( error ) {
+    return false;
+  }
+
+  if ( !write( temporaryPath ) ) {
+    fs::remove( temporaryPath, error );
+    return false;
+  }
+
+  fs::rename( temporaryPath, path, error );
+  if ( error ) {
+    fs::remove( temporaryPath, error );
+    return false;
+  }
+  return true;
+} // writeAtomically
+
+/**
+ * Writes the model to the model cache, with the files it was made from.
+ * Images are embedded so the cached model does not depend on the location of
+ * the original model. Files are written under temporary names first, so
+ * concurrent loads of the same model never read a partially written file.
+ */
+bool
+writeModelCache( osg::Node &                     model,
+                 boost::filesystem::path const & cachePath,
+                 std::set<std::string> const &   dependencies )
+{
+  boost::system::error_code error;
+  boost::filesystem::create_directories( cachePath.parent_path(), error );
+  if ( error ) {
+    return false;
+  }
+
+  // The model first: dependencies of a previous write then no longer match
+  // it, rather than new dependencies validating a previous model
+  bool written = writeAtomically(
+      cachePath, [&model]( boost::filesystem::path const & path ) {
+        osg::ref_ptr<osgDB::Options> options =
+            new osgDB::Options( "WriteImageHint=IncludeData" );
+        return osgDB::writeNodeFile( model, path.string(), options.get() );
+      } );
+
+  return written &&
+         writeAtomically(
+             modelCacheDependenciesPath( cachePath ),
+             [&dependencies]( boost::filesystem::path const & path ) {
+               std::ofstream file( path.string() );
+               for ( auto const & dependency : dependencies ) {
+                 file << fileStamp( dependency ) << ' ' << dependency << '\n';
+               }
+               return bool( file );
+             } );
+} // writeModelCache
+
+/**
+ * Makes the optimizer skip its operations once its load is cancelled. The
+ * optimizer itself can not be interrupted, but its passes check every object
+ * they are about to change.
+ */
+class CancelOptimizerCallback
+    : public osgUtil::Optimizer::IsOperationPermissibleForObjectCallback
+{
+public:
+  explicit CancelOptimizerCallback( std::atomic<bool> const & cancelled )
+      : mCancelled( cancelled )
+  {
+  }
+
+  bool isOperationPermissibleForObjectImplementation(
+      osgUtil::Optimizer const * optimizer,
+      osg::StateSet const *      stateSet,
+      unsigned int               option ) const override
+  {
+    return !mCancelled &&
+           IsOperationPermissibleForObjectCallback::
+               isOperationPermissibleForObjectImplementation(
+                   optimizer, stateSet, option );
+  }
+
+  bool isOperationPermissibleForObjectImplementation(
+      osgUtil::Optimizer const *  optimizer,
+      osg::StateAttribute const * attribute,
+      unsigned int                option ) const override
+  {
+    return !mCancelled &&
+           IsOperationPermissibleForObjectCallback::
+               isOperationPermissibleForObjectImplementation(
+                   optimizer, attribute, option );
+  }
+
+  bool isOperationPermissibleForObjectImplementation(
+      osgUtil::Optimizer const * optimizer,
+      osg::Drawable const *      drawable,
+      unsigned int               option ) const override
+  {
+    return !mCancelled &&
+           IsOperationPermissibleForObjectCallback::
+               isOperationPermissibleForObjectImplementation(
+                   optimizer, drawable, option );
+  }
+
+  bool isOperationPermissibleForObjectImplementation(
+      osgUtil::Optimizer const * optimizer,
+      osg::Node const *          node,
+      unsigned int               option ) const override
+  {
+    return !mCancelled &&
+           IsOperationPermissibleForObjectCallback::
+               isOperationPermissibleForObjectImplementation(
+                   optimizer, node, option );
+  }
+
+private:
+  std::atomic<bool> const & mCancelled;
+
+}; // class CancelOptimizerCallback
+
+/**
+ * Sets up the drawables of a model for rendering, builds their KdTrees and
+ * counts them. Drawables are the unit of draw calls, so this is the number to
+ * compare before and after optimizing. Stops once its load is cancelled.
+ */
+class PrepareDrawablesVisitor : public osg::NodeVisitor
+{
+public:
+  PrepareDrawablesVisitor( ModelOptimization const & optimization,
+                           std::atomic<bool> const & cancelled )
+      : osg::NodeVisitor( TRAVERSE_ALL_CHILDREN )
+      , mOptimization( optimization )
+      , mCancelled( cancelled )
+      , mKdTreeOptions()
+      , mDrawables( 0 )
+  {
+  }
+
+  std::size_t drawables() const
+  {
+    return mDrawables;
+  }
+
+private:
+  using osg::NodeVisitor::apply;
+
+  void apply( osg::Node & node ) override
+  {
+    if ( !mCancelled ) {
+      traverse( node );
+    }
+  }
+
+  void apply( osg::Drawable & drawable ) override
+  {
+    if ( mCancelled ) {
+      return;
+    }
+
+    if ( mOptimization.useVertexBufferObjects ) {
+      drawable.setUseDisplayList( false );
+      drawable.setUseVertexBufferObjects( true );
+    }
+
+    // As osg::KdTreeBuilder, which can not be stopped
+    auto geometry = drawable.asGeometry();
+    if ( mOptimization.buildKdTrees && geometry &&
+         !dynamic_cast<osg::KdTree *>( geometry->getShape() ) ) {
+      osg::ref_ptr<osg::KdTree> kdTree = new osg::KdTree;
+      if ( kdTree->build( mKdTreeOptions, geometry ) ) {
+        geometry->setShape( kdTree.get() );
+      }
+    }
+
+    ++mDrawables;
+  }
+
+  ModelOptimization const & mOptimization;
+  std::atomic<bool> const & mCancelled;
+  osg::KdTree::BuildOptions mKdTreeOptions;
+  std::size_t               mDrawables;
+
+}; // class PrepareDrawablesVisitor
+
+
+} // namespace
+
+osg::ref_ptr<osg::Node>
+loadModelFile( std::string const &       filename,
+               ModelOptimization const & optimization,
+               LoadMetrics &             metrics,
+               std::atomic<double> &     progress,
+               std::atomic<bool> const & cancelled )
+{
+  namespace fs = boost::filesystem;
+
+  auto start = Clock::now();
+
+  boost::system::error_code error;
+  auto                      size = fs::file_size( filename, error );
+  metrics.fileSize               = error ? 0 : size;
+
+  // Let the plugins resolve referenced files (textures, materials, ...)
+  auto options   = modelReadOptions( filename );
+  auto cachePath = fs::path();
+  if ( optimization.useCache ) {
+    auto cacheOptimization = optimization;
+    if ( cacheOptimization.cacheDirectory.empty() ) {
+      cacheOptimization.cacheDirectory =
+          QOSGWindow::defaultModelCacheDirectory();
+    }
+    cachePath = modelCachePath( filename, *options, cacheOptimization );
+  }
+
+  osg::ref_ptr<osg::Node> model;
+  if ( !cachePath.empty() && modelCacheValid( cachePath ) ) {
+    auto cacheSize = fs::file_size( cachePath, error );
+    model          = readModel( cachePath.string(),
+                       options.get(),
+                       error ? 0 : cacheSize,
+                       progress,
+                       cancelled );
+    metrics.fromCache = model.valid();
+  }
+
+  osg::ref_ptr<RecordingFindFileCallback> dependencies =
+      new RecordingFindFileCallback;
+  if ( !metrics.fromCache && !cancelled ) {
+    options->setFindFileCallback( dependencies.get() );
+    model = readModel(
+        filename, options.get(), metrics.fileSize, progress, cancelled );
+  }
+  metrics.readSeconds = secondsSince( start );
+
+  if ( !model || cancelled ) {
+    return nullptr;
+  }
+
+  if ( !metrics.fromCache && optimization.optimizerOptions != 0 ) {
+    start = Clock::now();
+    osgUtil::Optimizer optimizer;
+    optimizer.setIsOperationPermissibleForObjectCallback(
+        new CancelOptimizerCallback( cancelled ) );
+    optimizer.optimize( model.get(), optimization.optimizerOptions );
+    metrics.optimizeSeconds = secondsSince( start );
+  }
+
+  if ( !metrics.fromCache && !cachePath.empty() && !cancelled ) {
+    start = Clock::now();
+    writeModelCache( *model, cachePath, dependencies->files() );
+    metrics.cacheSeconds = secondsSince( start );
+  }
+
+  if ( cancelled ) {
+    return nullptr;
+  }
+
+  start = Clock::now();
+  PrepareDrawablesVisitor prepare( optimization, cancelled );
+  model->accept( prepare );
+  metrics.drawables = prepare.drawables();
+  metrics.optimizeSeconds += secondsSince( start );
+
+  return cancelled ? nullptr : model;
+} // loadModelFile
+
 QOSGWindow::QOSGWindow( QWidget * parent )
     : QMainWindow( parent )
     , mTraits()
@@ -52,15 +682,73 @@ QOSGWindow::QOSGWindow( QWidget * parent )
     , mViewer()
     , mRootNode()
     , mTimer( nullptr )
+    , mRenderMode( RenderMode::OnDemand )
+    , mOptimization()
+    , mLoaderPool()
+    , mLoads()
+    , mNextLoadId( 1 )
 {
+  // Leave a core for the GUI and rendering
+  auto cores  = std::thread::hardware_concurrency();
+  mLoaderPool = std::make_unique<boost::asio::thread_pool>(
+      cores > 2 ? cores - 1 : 2 );
+
   setupGUI();
   setupGraphics();
 } // QOSGWindow::QOSGWindow
 
 QOSGWindow::~QOSGWindow()
 {
+  // Drop queued loads and wait for the ones in progress to stop
+  cancelAllLoads();
+  mLoaderPool->stop();
+  mLoaderPool->join();
 } // QOSGWindow::~QOSGWindow
 
+void
+QOSGWindow::setModelOptimization( ModelOptimization const & optimization )
+{
+  mOptimization = optimization;
+} // QOSGWindow::setModelOptimization
+
+ModelOptimization const &
+QOSGWindow::modelOptimization() const
+{
+  return mOptimization;
+} // QOSGWindow::modelOptimization
+
+void
+QOSGWindow::clearModelCache()
+{
+  namespace fs = boost::filesystem;
+
+  auto directory = mOptimization.cacheDirectory.empty()
+                       ? defaultModelCacheDirectory()
+                       : mOptimization.cacheDirectory;
+
+  // Only remove the cached models, in case the directory is shared
+  boost::system::error_code error;
+  for ( fs::directory_iterator iter( directory, error ), end;
+        !error && iter != end;
+        iter.increment( error ) ) {
+    auto extension = iter->path().extension();
+    if ( extension == ".osgb" || extension == ".deps" ) {
+      boost::system::error_code removeError;
+      fs::remove( iter->path(), removeError );
+    }
+  }
+} // QOSGWindow::clearModelCache
+
+std::string
+QOSGWindow::defaultModelCacheDirectory()
+{
+  auto cache = QStandardPaths::writableLocation(
+      QStandardPaths::GenericCacheLocation );
+  return ( boost::filesystem::path( cache.toStdString() ) / "qtosgboost" /
+           "models" )
+      .string();
+} // QOSGWindow::defaultModelCacheDirectory
+
 class ResizeHandler : public QObject
 {
 public:
@@ -95,61 +783,260 @@ QOSGWindow::setupGUI()
   QObject::connect(
       openAction, &QAction::triggered, this, &QOSGWindow::openModel );
 
+  auto cancelAction = fileMenu->addAction( tr( "&Cancel Loading" ) );
+  QObject::connect(
+      cancelAction, &QAction::triggered, [this]() { cancelAllLoads(); } );
+
+  fileMenu->addSeparator();
+
+  auto optimizeAction = fileMenu->addAction( tr( "O&ptimize Models" ) );
+  optimizeAction->setCheckable( true );
+  optimizeAction->setChecked( mOptimization.optimizerOptions != 0 );
+  QObject::connect( optimizeAction, &QAction::toggled, [this]( bool checked ) {
+    mOptimization.optimizerOptions = checked ? kDefaultOptimizerOptions : 0;
+  } );
+
+  auto cacheAction = fileMenu->addAction( tr( "Use Model Cac&he" ) );
+  cacheAction->setCheckable( true );
+  cacheAction->setChecked( mOptimization.useCache );
+  QObject::connect( cacheAction, &QAction::toggled, [this]( bool checked ) {
+    mOptimization.useCache = checked;
+  } );
+
+  auto clearCacheAction = fileMenu->addAction( tr( "C&lear Model Cache" ) );
+  QObject::connect( clearCacheAction, &QAction::triggered, [this]() {
+    clearModelCache();
+  } );
+
   fileMenu->addSeparator();
 
   auto exitAction = fileMenu->addAction( tr( "E&xit" ) );
   QObject::connect(
       exitAction, &QAction::triggered, qApp, &QApplication::exit );
 
+  auto viewMenu = menuBar()->addMenu( tr( "View" ) );
+
+  auto renderGroup = new QActionGroup( this );
+  auto addRenderMode = [this, viewMenu, renderGroup]( QString const & name,
+                                                      RenderMode      mode ) {
+    auto action = renderGroup->addAction( viewMenu->addAction( name ) );
+    action->setCheckable( true );
+    action->setChecked( mode == mRenderMode );
+    QObject::connect( action, &QAction::triggered, [this, mode]() {
+      setRenderMode( mode );
+    } );
+  };
+  addRenderMode( tr( "Render On &Demand" ), RenderMode::OnDemand );
+  addRenderMode( tr( "Render &Continuously" ), RenderMode::Continuous );
+
+  viewMenu->addSeparator();
+
+  using osgViewer::ViewerBase;
+  auto threadingGroup = new QActionGroup( this );
+  auto addThreadingModel =
+      [this, viewMenu, threadingGroup]( QString const &             name,
+                                        ViewerBase::ThreadingModel model ) {
+        auto action =
+            threadingGroup->addAction( viewMenu->addAction( name ) );
+        action->setCheckable( true );
+        action->setChecked( model == ViewerBase::DrawThreadPerContext );
+        QObject::connect( action, &QAction::triggered, [this, model]() {
+          setThreadingModel( model );
+        } );
+      };
+  addThreadingModel( tr( "Single Threaded" ), ViewerBase::SingleThreaded );
+  addThreadingModel( tr( "Cull/Draw Thread Per Context" ),
+                     ViewerBase::CullDrawThreadPerContext );
+  addThreadingModel( tr( "Draw Thread Per Context" ),
+                     ViewerBase::DrawThreadPerContext );
+  addThreadingModel( tr( "Cull Thread Per Camera, Draw Thread Per Context" ),
+                     ViewerBase::CullThreadPerCameraDrawThreadPerContext );
+
   auto centralWidget = new QWidget( this );
   setCentralWidget( centralWidget );
 } // ::setupGUI
 
+void
+QOSGWindow::setRenderMode( RenderMode mode )
+{
+  mRenderMode = mode;
+  if ( mTimer ) {
+    // Continuous frames are throttled by the (vsync'ed) buffer swap
+    mTimer->start( mode == RenderMode::Continuous ? 0
+                                                  : kOnDemandPollInterval );
+  }
+  requestRedraw();
+} // QOSGWindow::setRenderMode
+
+RenderMode
+QOSGWindow::renderMode() const
+{
+  return mRenderMode;
+} // QOSGWindow::renderMode
+
+void
+QOSGWindow::setThreadingModel( osgViewer::ViewerBase::ThreadingModel model )
+{
+  // Stops and restarts the rendering threads as needed
+  mViewer->setThreadingModel( model );
+  requestRedraw();
+} // QOSGWindow::setThreadingModel
+
+osgViewer::ViewerBase::ThreadingModel
+QOSGWindow::threadingModel() const
+{
+  return mViewer->getThreadingModel();
+} // QOSGWindow::threadingModel
+
+void
+QOSGWindow::requestRedraw()
+{
+  if ( mViewer ) {
+    mViewer->requestRedraw();
+  }
+} // QOSGWindow::requestRedraw
+
+void
+QOSGWindow::renderFrame()
+{
+  mergeLoadedModels();
+
+  // checkNeedToDoFrame() covers pending input events, redraw requests (e.g.
+  // from manipulators still animating) and scene update callbacks
+  if ( mRenderMode == RenderMode::Continuous ||
+       mViewer->checkNeedToDoFrame() ) {
+    mViewer->frame( USE_REFERENCE_TIME );
+  }
+} // QOSGWindow::renderFrame
+
 void
 QOSGWindow::openModel()
 {
-  auto filename = QFileDialog::getOpenFileName(
+  auto filenames = QFileDialog::getOpenFileNames(
       this,
-      tr( "Open 3D Model File" ),
+      tr( "Open 3D Model Files" ),
       QString(),
       tr( "3D Models (*.obj *.flt *.osg);;All Files (*.*)" ) );
 
-  if ( filename.isEmpty() ) {
-    return;
+  for ( auto const & filename : filenames ) {
+    if ( !boost::filesystem::exists( filename.toStdString() ) ) {
+      QMessageBox::warning( this,
+                            tr( "Load Model" ),
+                            tr( "%1: Non-existing file: %2" )
+                                .arg( QString::fromStdString( utcTimestamp() ) )
+                                .arg( filename ) );
+      continue;
+    }
+
+    loadModel( filename.toStdString() );
+  }
+} // QOSGWindow::openModel
+
+LoadId
+QOSGWindow::loadModel( std::string const & filename )
+{
+  auto load          = std::make_shared<ModelLoad>();
+  load->id           = mNextLoadId++;
+  load->filename     = filename;
+  load->timestamp    = utcTimestamp();
+  load->optimization = mOptimization;
+  load->queued       = Clock::now();
+  mLoads.push_back( load );
+
+  // Resolved here, as QStandardPaths is better not used on the workers
+  if ( load->optimization.cacheDirectory.empty() ) {
+    load->optimization.cacheDirectory = defaultModelCacheDirectory();
   }
 
-  using boost::gregorian::day_clock;
-  using boost::posix_time::ptime;
-  using boost::posix_time::second_clock;
-  using boost::posix_time::to_simple_string;
+  // The worker only touches the ModelLoad, never the window or the scene
+  boost::asio::post( *mLoaderPool, [load]() {
+    load->metrics.queueSeconds = secondsSince( load->queued );
 
-  ptime todayUtc( day_clock::universal_day(),
-                  second_clock::universal_time().time_of_day() );
-  auto  timestamp = to_simple_string( todayUtc );
+    if ( !load->cancelled ) {
+      load->model = loadModelFile( load->filename,
+                                   load->optimization,
+                                   load->metrics,
+                                   load->progress,
+                                   load->cancelled );
+    }
+
+    load->finished.store( true, std::memory_order_release );
+  } );
+
+  return load->id;
+} // QOSGWindow::loadModel
+
+void
+QOSGWindow::cancelLoad( LoadId id )
+{
+  for ( auto & load : mLoads ) {
+    if ( load->id == id ) {
+      load->cancelled = true;
+    }
+  }
+} // QOSGWindow::cancelLoad
 
-  if ( !boost::filesystem::exists( filename.toStdString() ) ) {
-    QMessageBox::warning( this,
-                          tr( "Load Model" ),
-                          tr( "%1: Non-existing file: %2" )
-                              .arg( QString::fromStdString( timestamp ) )
-                              .arg( filename ) );
-    return;
+void
+QOSGWindow::cancelAllLoads()
+{
+  for ( auto & load : mLoads ) {
+    load->cancelled = true;
   }
+} // QOSGWindow::cancelAllLoads
+
+void
+QOSGWindow::mergeLoadedModels()
+{
+  // Called on the GUI thread between frame() calls, so no update or cull
+  // traversal is running. With DrawThreadPerContext the draw thread may still
+  // be drawing the previous frame, which only uses the drawables and state
+  // sets already in the scene, so adding children to the root is safe.
+  std::vector<std::shared_ptr<ModelLoad>> finished;
+  for ( auto iter = mLoads.begin(); iter != mLoads.end(); ) {
+    auto & load = *iter;
+
+    double progress = load->progress;
+    if ( progress != load->reportedProgress ) {
+      load->reportedProgress = progress;
+      modelLoadProgress( load->id, load->filename, progress );
+    }
 
-  auto model = osgDB::readNodeFile( filename.toStdString() );
-  if ( !model ) {
-    modelLoaded( false, filename.toStdString(), timestamp );
-    return;
+    if ( load->finished.load( std::memory_order_acquire ) ) {
+      finished.push_back( load );
+      iter = mLoads.erase( iter );
+    }
+    else {
+      ++iter;
+    }
   }
 
-  mRootNode->addChild( model );
+  for ( auto & load : finished ) {
+    auto & metrics    = load->metrics;
+    metrics.cancelled = load->cancelled;
+    bool success      = !metrics.cancelled && load->model.valid();
 
-  mViewer->getCamera();
-  auto manip = mViewer->getCameraManipulator();
-  manip->home( 1.0 );
+    if ( success ) {
+      auto start = Clock::now();
+      mRootNode->addChild( load->model );
 
-  modelLoaded( true, filename.toStdString(), timestamp );
-} // QOSGWindow::openModel
+      auto manip = mViewer->getCameraManipulator();
+      manip->home( 1.0 );
+      requestRedraw();
+      metrics.mergeSeconds = secondsSince( start );
+    }
+
+    // Handlers may open modal dialogs, which would block this (timer) slot
+    // and with it the rendering and the merging of other loads, so signal
+    // from the event loop instead
+    QMetaObject::invokeMethod(
+        this,
+        [this, load, success]() {
+          modelLoaded(
+              success, load->filename, load->timestamp, load->metrics );
+        },
+        Qt::QueuedConnection );
+  }
+} // QOSGWindow::mergeLoadedModels
 
 void
 QOSGWindow::setupGraphics()
@@ -173,6 +1060,7 @@ QOSGWindow::setupGraphics()
   mTraits->sharedContext    = 0;
   mTraits->sampleBuffers    = displaySettings->getMultiSamples();
   mTraits->samples          = displaySettings->getNumMultiSamples();
+  mTraits->vsync            = true;
   mTraits->setUndefinedScreenDetailsToDefaultScreen();
 
   mTraits->inheritedWindowData =
@@ -181,7 +1069,7 @@ QOSGWindow::setupGraphics()
       osg::GraphicsContext::createGraphicsContext( mTraits.get() );
 
   mViewer = new osgViewer::Viewer;
-  mViewer->setThreadingModel( osgViewer::ViewerBase::SingleThreaded );
+  mViewer->setThreadingModel( osgViewer::ViewerBase::DrawThreadPerContext );
 
   auto camera = mViewer->getCamera();
   camera->setViewport( 0, 0, size.width(), size.height() );
@@ -195,22 +1083,22 @@ QOSGWindow::setupGraphics()
   mViewer->setCameraManipulator( manip );
   mViewer->addEventHandler(
       new osgGA::StateSetManipulator( camera->getOrCreateStateSet() ) );
-  mViewer->addEventHandler( new osgViewer::ThreadingHandler );
+  // No osgViewer::ThreadingHandler, the View menu sets the threading model
   mViewer->addEventHandler( new osgViewer::WindowSizeHandler );
   mViewer->addEventHandler( new osgViewer::StatsHandler );
 
   mViewer->realize();
 
   mTimer = new QTimer( this );
-  QObject::connect( mTimer, &QTimer::timeout, [this]() {
-    mViewer->frame( USE_REFERENCE_TIME );
-  } );
-  mTimer->start( 10 );
+  mTimer->setTimerType( Qt::PreciseTimer );
+  QObject::connect( mTimer, &QTimer::timeout, [this]() { renderFrame(); } );
+  setRenderMode( mRenderMode );
 
   auto resizeHandler = new ResizeHandler( centralWidget() );
   centralWidget()->installEventFilter( resizeHandler );
   resizeHandler->resized.connect( [this]( int width, int height ) {
     mGraphicsContext->resizedImplementation( 0, 0, width, height );
+    requestRedraw();
   } );
 
 } // QOSGWindow::setupGraphics
@@ -6,44 +6,183 @@
 
 #include <osg/GraphicsContext>
 #include <osg/Group>
+#include <osgUtil/Optimizer>
 #include <osgViewer/Viewer>
 
 #include <QtWidgets/QMainWindow>
 
 #include <boost/signals2.hpp>
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
 class QTimer;
 
+namespace boost {
+namespace asio {
+class thread_pool;
+} // namespace asio
+} // namespace boost
+
 namespace osgViewer {
 class Viewer;
 } // namespace osgViewer
 
 namespace qtosgboost {
 
+/** Identifies a model load started with QOSGWindow::loadModel. */
+using LoadId = std::size_t;
+
+/** Measurements of a single model load, reported with modelLoaded. */
+struct LoadMetrics
+{
+  bool           cancelled       = false; /**< Load was cancelled. */
+  bool           fromCache       = false; /**< Read from the model cache. */
+  std::uintmax_t fileSize        = 0;     /**< Size of the file in bytes. */
+  std::size_t    drawables       = 0;     /**< Drawables in the model. */
+  double         queueSeconds    = 0.0;   /**< Time waiting for a worker. */
+  double         readSeconds     = 0.0;   /**< Time reading the file. */
+  double         optimizeSeconds = 0.0;   /**< Time optimizing the model. */
+  double         cacheSeconds    = 0.0;   /**< Time writing the cache. */
+  double         mergeSeconds    = 0.0;   /**< Time adding it to the scene. */
+};
+
+/** Optimizations run on models after loading. */
+constexpr unsigned int kDefaultOptimizerOptions =
+    osgUtil::Optimizer::DEFAULT_OPTIMIZATIONS |
+    osgUtil::Optimizer::SPATIALIZE_GROUPS | osgUtil::Optimizer::INDEX_MESH |
+    osgUtil::Optimizer::VERTEX_POSTTRANSFORM |
+    osgUtil::Optimizer::VERTEX_PRETRANSFORM;
+
+/**
+ * Processing of models after they are read, on the loading thread. The result
+ * of the optimizer is stored in the model cache as a binary .osgb file, keyed
+ * by the model file (path, modification time and size), the reader option
+ * string and optimizerOptions, so later loads of the same model read that
+ * instead. The cached model is also checked against the files the plugin
+ * looked up while reading it (textures, material libraries, external
+ * references), but not against files a plugin opens without looking them up
+ * through osgDB::findDataFile.
+ */
+struct ModelOptimization
+{
+  /** osgUtil::Optimizer::OptimizationOptions, 0 to not optimize. */
+  unsigned int optimizerOptions = kDefaultOptimizerOptions;
+
+  /** Draw with vertex buffer objects instead of display lists. */
+  bool useVertexBufferObjects = true;
+
+  /** Build KdTrees for fast intersection tests, e.g. picking. */
+  bool buildKdTrees = true;
+
+  /** Read and write optimized models from and to the model cache. */
+  bool useCache = true;
+
+  /** Model cache directory, empty for defaultModelCacheDirectory(). */
+  std::string cacheDirectory;
+};
+
+/**
+ * Loads a model file as configured by optimization on the calling thread:
+ * reads it from the model cache if possible, otherwise reads, optimizes and
+ * caches it, then prepares it for rendering. Returns nullptr if the file can
+ * not be read or once cancelled is set. Used by QOSGWindow::loadModel on its
+ * loader threads.
+ */
+QTOSGBOOST_API osg::ref_ptr<osg::Node>
+loadModelFile( std::string const &       filename,
+               ModelOptimization const & optimization,
+               LoadMetrics &             metrics,
+               std::atomic<double> &     progress,
+               std::atomic<bool> const & cancelled );
+
+/** How frames are scheduled by QOSGWindow. */
+enum class RenderMode
+{
+  OnDemand,  /**< Only on input, resizing or scene changes. */
+  Continuous /**< Every frame, paced by vsync. */
+};
+
 class QTOSGBOOST_API QOSGWindow : public QMainWindow
 {
 public:
   explicit QOSGWindow( QWidget * parent = nullptr );
   ~QOSGWindow();
 
+  /** Sets how frames are scheduled, defaults to RenderMode::OnDemand. */
+  void       setRenderMode( RenderMode mode );
+  RenderMode renderMode() const;
+
+  /**
+   * Sets the OSG threading model used for rendering, defaults to
+   * DrawThreadPerContext. May be changed while rendering.
+   */
+  void setThreadingModel( osgViewer::ViewerBase::ThreadingModel model );
+  osgViewer::ViewerBase::ThreadingModel threadingModel() const;
+
+  /** Requests a new frame to be rendered, e.g. after changing the scene. */
+  void requestRedraw();
+
+  /** Sets the processing of models loaded after this call. */
+  void setModelOptimization( ModelOptimization const & optimization );
+  ModelOptimization const & modelOptimization() const;
+
+  /** Removes all models from the model cache. */
+  void clearModelCache();
+
+  /** The user's cache directory for qtosgboost models. */
+  static std::string defaultModelCacheDirectory();
+
+  /**
+   * Starts loading the specified model on a worker thread. The loaded model
+   * is added to the scene between calls to frame(), after which modelLoaded is
+   * signalled. Several models may be loading at the same time.
+   */
+  LoadId loadModel( std::string const & filename );
+
+  /** Cancels the specified load, if it has not finished yet. */
+  void cancelLoad( LoadId id );
+
+  /** Cancels all unfinished loads. */
+  void cancelAllLoads();
+
   boost::signals2::signal<void( bool                success,
                                 std::string const & filename,
-                                std::string const & dateTme )>
+                                std::string const & dateTme,
+                                LoadMetrics const & metrics )>
       modelLoaded;
 
+  /** Signals the fraction [0,1] of the file read so far. */
+  boost::signals2::signal<void(
+      LoadId id, std::string const & filename, double progress )>
+      modelLoadProgress;
+
 private:
+  struct ModelLoad;
+
   void setupGUI();
   void openModel();
   void setupGraphics();
+  void mergeLoadedModels();
+  void renderFrame();
 
   osg::ref_ptr<osg::GraphicsContext::Traits> mTraits;
   osg::ref_ptr<osg::GraphicsContext>         mGraphicsContext;
   osg::ref_ptr<osgViewer::Viewer>            mViewer;
   osg::ref_ptr<osg::Group>                   mRootNode;
 
-  QTimer * mTimer;
+  QTimer *   mTimer;
+  RenderMode mRenderMode;
+
+  ModelOptimization mOptimization;
+
+  std::unique_ptr<boost::asio::thread_pool> mLoaderPool;
+  std::vector<std::shared_ptr<ModelLoad>>   mLoads;
+  LoadId                                    mNextLoadId;
 
 }; // class QOSGWindow
 
@@ -20,6 +20,12 @@ extern "C" {
 #  else
 #    define QTOSGBOOST_API __declspec( dllimport )
 #  endif
+#elif defined( __GNUC__ ) || defined( __clang__ )
+#  if defined qtosgboost_STATIC
+#    define QTOSGBOOST_API
+#  else
+#    define QTOSGBOOST_API __attribute__( ( visibility( "default" ) ) )
+#  endif
 #else
 #  define QTOSGBOOST_API
 #endif
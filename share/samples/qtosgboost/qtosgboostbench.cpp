@@ -0,0 +1,475 @@
+// Headless frame-time benchmark for the qtosgboost scene setup.
+//
+// Loads a model as the viewer does (qtosgboost::loadModelFile, so optimized,
+// prepared and cached unless disabled), renders it into an off-screen pbuffer
+// while flying the camera along a scripted orbit, and writes the load metrics
+// and the event, update, cull and draw times of every frame to JSON. A
+// previous result can be given as baseline to compare with.
+//
+// On machines without a GPU, run it under a virtual X server with Mesa's
+// software renderer, e.g.:
+//   xvfb-run -a qtosgboostbench --software --output result.json
+
+#include <qtosgboost/qtosgboost.hpp>
+
+#include <osg/GL>
+#include <osg/Group>
+#include <osg/Math>
+#include <osg/MatrixTransform>
+#include <osgViewer/Viewer>
+
+#include <boost/program_options.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+using ThreadingModel = osgViewer::ViewerBase::ThreadingModel;
+
+/** The timings recorded per frame, in milliseconds. */
+std::vector<std::string> const kMetrics = {
+    "frame", "event", "update", "cull", "draw" };
+
+using FrameTimes = std::map<std::string, double>;
+
+std::map<std::string, ThreadingModel> const kThreadingModels = {
+    { "SingleThreaded", osgViewer::ViewerBase::SingleThreaded },
+    { "CullDrawThreadPerContext",
+      osgViewer::ViewerBase::CullDrawThreadPerContext },
+    { "DrawThreadPerContext", osgViewer::ViewerBase::DrawThreadPerContext },
+    { "CullThreadPerCameraDrawThreadPerContext",
+      osgViewer::ViewerBase::CullThreadPerCameraDrawThreadPerContext } };
+
+struct Summary
+{
+  double mean   = 0.0;
+  double median = 0.0;
+  double p95    = 0.0;
+  double max    = 0.0;
+};
+
+Summary
+summarize( std::vector<double> values )
+{
+  Summary summary;
+  if ( values.empty() ) {
+    return summary;
+  }
+
+  std::sort( values.begin(), values.end() );
+  for ( auto value : values ) {
+    summary.mean += value;
+  }
+  summary.mean /= values.size();
+  summary.median = values[values.size() / 2];
+  summary.p95    = values[std::min( values.size() - 1,
+                                    std::size_t( values.size() * 0.95 ) )];
+  summary.max    = values.back();
+  return summary;
+} // summarize
+
+/**
+ * Replicates the model on a grid x grid x grid lattice, sharing the model
+ * between all instances, to procedurally scale up the scene.
+ */
+osg::ref_ptr<osg::Node>
+buildScene( osg::ref_ptr<osg::Node> model, int grid )
+{
+  if ( grid <= 1 ) {
+    return model;
+  }
+
+  auto spacing = model->getBound().radius() * 2.5;
+  auto offset  = ( grid - 1 ) * spacing * 0.5;
+  auto scene   = new osg::Group;
+  for ( int i = 0; i < grid; ++i ) {
+    for ( int j = 0; j < grid; ++j ) {
+      for ( int k = 0; k < grid; ++k ) {
+        auto transform = new osg::MatrixTransform;
+        transform->setMatrix( osg::Matrixd::translate( i * spacing - offset,
+                                                       j * spacing - offset,
+                                                       k * spacing - offset ) );
+        transform->addChild( model );
+        scene->addChild( transform );
+      }
+    }
+  }
+  return scene;
+} // buildScene
+
+/** Retrieves the specified attribute of a frame in milliseconds. */
+double
+statsMilliseconds( osg::Stats *        stats,
+                   unsigned            frameNumber,
+                   std::string const & attribute )
+{
+  double seconds = 0.0;
+  if ( stats ) {
+    stats->getAttribute( frameNumber, attribute, seconds );
+  }
+  return seconds * 1000.0;
+} // statsMilliseconds
+
+/** Quotes the string for use in JSON, e.g. for Windows paths. */
+std::string
+jsonString( std::string const & value )
+{
+  std::string quoted = "\"";
+  for ( auto c : value ) {
+    if ( c == '"' || c == '\\' ) {
+      quoted += '\\';
+    }
+    quoted += c;
+  }
+  return quoted + '"';
+} // jsonString
+
+void
+writeSummary( std::ostream & out, Summary const & summary )
+{
+  out << "{ \"mean\": " << summary.mean << ", \"median\": " << summary.median
+      << ", \"p95\": " << summary.p95 << ", \"max\": " << summary.max << " }";
+} // writeSummary
+
+/**
+ * Compares the summaries with those of the baseline result, returning false
+ * if the mean frame time regressed more than maxRegression percent.
+ */
+bool
+compareWithBaseline( std::map<std::string, Summary> const & summaries,
+                     std::string const &                    baselineFile,
+                     double                                 maxRegression )
+{
+  boost::property_tree::ptree baseline;
+  boost::property_tree::read_json( baselineFile, baseline );
+
+  std::cout << "Comparison with baseline " << baselineFile << " (ms):\n"
+            << std::setw( 8 ) << "metric" << std::setw( 12 ) << "baseline"
+            << std::setw( 12 ) << "current" << std::setw( 10 ) << "change"
+            << '\n';
+
+  bool passed = true;
+  for ( auto const & metric : kMetrics ) {
+    auto before = baseline.get<double>( "summary." + metric + ".mean", 0.0 );
+    auto after  = summaries.at( metric ).mean;
+    auto change = before > 0.0 ? ( after - before ) / before * 100.0 : 0.0;
+
+    std::cout << std::setw( 8 ) << metric << std::setw( 12 ) << before
+              << std::setw( 12 ) << after << std::setw( 9 ) << std::showpos
+              << change << std::noshowpos << "%\n";
+
+    if ( metric == "frame" && change > maxRegression ) {
+      passed = false;
+    }
+  }
+
+  return passed;
+} // compareWithBaseline
+
+} // namespace
+
+int
+main( int argc, char ** argv )
+{
+  namespace po = boost::program_options;
+
+  std::string model;
+  std::string output;
+  std::string baseline;
+  std::string threading;
+  int         grid;
+  int         frames;
+  int         warmup;
+  int         width;
+  int         height;
+  double      maxRegression;
+
+  po::options_description options( "qtosgboostbench options" );
+  options.add_options()( "help,h", "Show this help" )(
+      "model,m",
+      po::value( &model )->default_value( "models/testSphere.osg" ),
+      "Model file to render" )(
+      "grid,g",
+      po::value( &grid )->default_value( 1 ),
+      "Render grid^3 instances of the model" )(
+      "frames,f",
+      po::value( &frames )->default_value( 500 ),
+      "Number of measured frames" )(
+      "warmup,w",
+      po::value( &warmup )->default_value( 20 ),
+      "Number of frames rendered before measuring" )(
+      "width", po::value( &width )->default_value( 1280 ), "Pbuffer width" )(
+      "height", po::value( &height )->default_value( 720 ), "Pbuffer height" )(
+      "threading,t",
+      po::value( &threading )->default_value( "DrawThreadPerContext" ),
+      "OSG threading model: SingleThreaded, CullDrawThreadPerContext, "
+      "DrawThreadPerContext, CullThreadPerCameraDrawThreadPerContext" )(
+      "software", "Use Mesa's software renderer (LIBGL_ALWAYS_SOFTWARE)" )(
+      "optimize", "Optimize the model after loading (default)" )(
+      "no-optimize", "Do not optimize the model after loading" )(
+      "no-cache", "Do not read or write the model cache" )(
+      "output,o",
+      po::value( &output )->default_value( "qtosgboostbench.json" ),
+      "JSON file to write the results to" )(
+      "baseline,b",
+      po::value( &baseline ),
+      "JSON result of a previous run to compare with" )(
+      "max-regression",
+      po::value( &maxRegression )->default_value( 10.0 ),
+      "Fail if the mean frame time regressed more than this percentage" );
+
+  po::variables_map vm;
+  try {
+    po::store( po::parse_command_line( argc, argv, options ), vm );
+    po::notify( vm );
+  }
+  catch ( po::error const & error ) {
+    std::cerr << error.what() << '\n' << options << '\n';
+    return 1;
+  }
+
+  if ( vm.count( "help" ) ) {
+    std::cout << options << '\n';
+    return 0;
+  }
+
+  if ( frames <= 0 || warmup < 0 || grid < 1 ) {
+    std::cerr << "frames and grid must be positive, warmup not negative\n";
+    return 1;
+  }
+
+  if ( vm.count( "optimize" ) && vm.count( "no-optimize" ) ) {
+    std::cerr << "Only one of optimize and no-optimize may be given\n";
+    return 1;
+  }
+  bool optimize = !vm.count( "no-optimize" );
+
+  auto threadingModel = kThreadingModels.find( threading );
+  if ( threadingModel == kThreadingModels.end() ) {
+    std::cerr << "Unknown threading model: " << threading << '\n';
+    return 1;
+  }
+
+  if ( vm.count( "software" ) ) {
+#if defined( WIN32 )
+    _putenv_s( "LIBGL_ALWAYS_SOFTWARE", "1" );
+#else
+    setenv( "LIBGL_ALWAYS_SOFTWARE", "1", 1 );
+#endif
+  }
+
+  // ---------------
+  // Load the scene
+  // ---------------
+  qtosgboost::ModelOptimization optimization;
+  if ( !optimize ) {
+    optimization.optimizerOptions = 0;
+  }
+  optimization.useCache = !vm.count( "no-cache" );
+
+  qtosgboost::LoadMetrics load;
+  std::atomic<double>     progress{ 0.0 };
+  std::atomic<bool>       cancelled{ false };
+
+  auto node = qtosgboost::loadModelFile(
+      model, optimization, load, progress, cancelled );
+  if ( !node ) {
+    std::cerr << "Unable to load model: " << model << '\n';
+    return 1;
+  }
+  std::cout << "Loaded " << model << ": " << load.drawables << " drawables, "
+            << ( load.fromCache ? "read from cache" : "read" ) << " in "
+            << load.readSeconds << " s, optimized in " << load.optimizeSeconds
+            << " s\n";
+  auto scene = buildScene( node, grid );
+
+  // -----------------------------------
+  // Set up the off-screen rendering
+  // -----------------------------------
+  osg::ref_ptr<osg::GraphicsContext::Traits> traits =
+      new osg::GraphicsContext::Traits;
+  traits->readDISPLAY();
+  traits->x                = 0;
+  traits->y                = 0;
+  traits->width            = width;
+  traits->height           = height;
+  traits->windowDecoration = false;
+  traits->doubleBuffer     = false;
+  traits->pbuffer          = true;
+  traits->vsync            = false;
+  traits->sharedContext    = 0;
+  traits->setUndefinedScreenDetailsToDefaultScreen();
+
+  osg::ref_ptr<osg::GraphicsContext> context =
+      osg::GraphicsContext::createGraphicsContext( traits.get() );
+  if ( !context || !context->valid() ) {
+    std::cerr << "Unable to create pbuffer, is an X server available? "
+                 "(e.g. run with xvfb-run)\n";
+    return 1;
+  }
+
+  osg::ref_ptr<osgViewer::Viewer> viewer = new osgViewer::Viewer;
+  viewer->setThreadingModel( threadingModel->second );
+
+  auto camera = viewer->getCamera();
+  camera->setGraphicsContext( context );
+  camera->setViewport( 0, 0, width, height );
+  camera->setDrawBuffer( GL_FRONT );
+  camera->setReadBuffer( GL_FRONT );
+  camera->setClearColor( osg::Vec4( 0.08, 0.08, 0.5, 1.0 ) );
+  camera->setProjectionMatrixAsPerspective(
+      30.0, double( width ) / double( height ), 1.0, 10000.0 );
+
+  viewer->setSceneData( scene );
+  viewer->realize();
+
+  auto viewerStats = viewer->getViewerStats();
+  auto cameraStats = camera->getStats();
+  viewerStats->collectStats( "event", true );
+  viewerStats->collectStats( "update", true );
+  if ( cameraStats ) {
+    cameraStats->collectStats( "rendering", true );
+  }
+
+  // -------------------------------------
+  // Fly the camera on an orbit and render
+  // -------------------------------------
+  auto const & bound  = scene->getBound();
+  auto         center = bound.center();
+  auto         radius = bound.radius() * 3.0;
+
+  // Threaded models report the cull/draw stats of a frame only once it has
+  // been drawn, and the stats only keep a short history, so the stats of
+  // each frame are read a few frames later.
+  int const kStatsLag = 2;
+
+  std::vector<FrameTimes>                    measured;
+  std::vector<unsigned>                      frameNumbers;
+  std::vector<double>                        frameTimes;
+  std::map<std::string, std::vector<double>> values;
+
+  auto timer = osg::Timer::instance();
+  for ( int i = 0; i < warmup + frames + kStatsLag; ++i ) {
+    auto t = double( std::min( i, warmup + frames - 1 ) ) /
+             double( warmup + frames );
+    auto angle = 2.0 * osg::PI * t;
+    osg::Vec3d eye( center.x() + radius * std::cos( angle ),
+                    center.y() + radius * std::sin( angle ),
+                    center.z() + radius * 0.3 * std::sin( 2.0 * angle ) );
+    camera->setViewMatrixAsLookAt( eye, center, osg::Vec3d( 0, 0, 1 ) );
+
+    auto start = timer->tick();
+    viewer->frame();
+    auto elapsed = timer->delta_m( start, timer->tick() );
+
+    if ( i >= warmup && i < warmup + frames ) {
+      frameNumbers.push_back( viewer->getFrameStamp()->getFrameNumber() );
+      frameTimes.push_back( elapsed );
+    }
+
+    auto f = i - warmup - kStatsLag;
+    if ( f < 0 || f >= frames ) {
+      continue;
+    }
+
+    auto       number = frameNumbers[f];
+    FrameTimes times;
+    times["frame"] = frameTimes[f];
+    times["event"] = statsMilliseconds(
+        viewerStats, number, "Event traversal time taken" );
+    times["update"] = statsMilliseconds(
+        viewerStats, number, "Update traversal time taken" );
+    times["cull"] =
+        statsMilliseconds( cameraStats, number, "Cull traversal time taken" );
+    times["draw"] =
+        statsMilliseconds( cameraStats, number, "Draw traversal time taken" );
+
+    for ( auto const & metric : kMetrics ) {
+      values[metric].push_back( times[metric] );
+    }
+    measured.push_back( times );
+  }
+
+  std::map<std::string, Summary> summaries;
+  for ( auto const & metric : kMetrics ) {
+    summaries[metric] = summarize( values[metric] );
+  }
+
+  // -----------------
+  // Write the results
+  // -----------------
+  std::ofstream out( output );
+  if ( !out ) {
+    std::cerr << "Unable to write results to: " << output << '\n';
+    return 1;
+  }
+
+  out << "{\n"
+      << "  \"model\": " << jsonString( model ) << ",\n"
+      << "  \"grid\": " << grid << ",\n"
+      << "  \"instances\": " << grid * grid * grid << ",\n"
+      << "  \"width\": " << width << ",\n"
+      << "  \"height\": " << height << ",\n"
+      << "  \"threading\": " << jsonString( threading ) << ",\n"
+      << "  \"optimize\": " << ( optimize ? "true" : "false" ) << ",\n"
+      << "  \"load\": {\n"
+      << "    \"fromCache\": " << ( load.fromCache ? "true" : "false" )
+      << ",\n"
+      << "    \"drawables\": " << load.drawables << ",\n"
+      << "    \"readSeconds\": " << load.readSeconds << ",\n"
+      << "    \"optimizeSeconds\": " << load.optimizeSeconds << ",\n"
+      << "    \"cacheSeconds\": " << load.cacheSeconds << "\n"
+      << "  },\n"
+      << "  \"warmup\": " << warmup << ",\n"
+      << "  \"frames\": " << frames << ",\n"
+      << "  \"summary\": {\n";
+  for ( std::size_t m = 0; m < kMetrics.size(); ++m ) {
+    out << "    \"" << kMetrics[m] << "\": ";
+    writeSummary( out, summaries[kMetrics[m]] );
+    out << ( m + 1 < kMetrics.size() ? ",\n" : "\n" );
+  }
+  out << "  },\n"
+      << "  \"perFrame\": [\n";
+  for ( std::size_t f = 0; f < measured.size(); ++f ) {
+    out << "    { \"frameNumber\": " << frameNumbers[f];
+    for ( auto const & metric : kMetrics ) {
+      out << ", \"" << metric << "\": " << measured[f][metric];
+    }
+    out << ( f + 1 < measured.size() ? " },\n" : " }\n" );
+  }
+  out << "  ]\n"
+      << "}\n";
+  out.close();
+
+  std::cout << "Mean frame time: " << summaries["frame"].mean << " ms ("
+            << measured.size() << " frames), results written to " << output
+            << '\n';
+
+  if ( !baseline.empty() ) {
+    try {
+      if ( !compareWithBaseline( summaries, baseline, maxRegression ) ) {
+        std::cerr << "Mean frame time regressed more than " << maxRegression
+                  << "%\n";
+        return 2;
+      }
+    }
+    catch ( boost::property_tree::ptree_error const & error ) {
+      std::cerr << "Unable to read baseline: " << error.what() << '\n';
+      return 1;
+    }
+  }
+
+  return 0;
+
+} // main
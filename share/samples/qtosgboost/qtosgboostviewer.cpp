@@ -3,6 +3,7 @@
 
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QMessageBox>
+#include <QtWidgets/QStatusBar>
 
 int
 main( int argc, char ** argv )
@@ -11,16 +12,36 @@ main( int argc, char ** argv )
 
   qtosgboost::QOSGWindow window;
   window.resize( 800, 600 );
-  window.modelLoaded.connect( [win = &window]( bool                success,
-                                               std::string const & filename,
-                                               std::string const & timestamp ) {
+  window.modelLoaded.connect( [win = &window](
+                                  bool                            success,
+                                  std::string const &             filename,
+                                  std::string const &             timestamp,
+                                  qtosgboost::LoadMetrics const & metrics ) {
     auto qfilename = QString::fromStdString( filename );
     if ( success ) {
-      QMessageBox::information( win,
-                                QObject::tr( "Model load" ),
-                                QObject::tr( "%1: Loaded model: %2" )
-                                    .arg( QString::fromStdString( timestamp ) )
-                                    .arg( qfilename ) );
+      auto source = metrics.fromCache
+                        ? QObject::tr( "read from cache in %1 s" )
+                              .arg( metrics.readSeconds, 0, 'f', 2 )
+                        : QObject::tr( "%1 MB read in %2 s" )
+                              .arg( metrics.fileSize / ( 1024.0 * 1024.0 ),
+                                    0,
+                                    'f',
+                                    1 )
+                              .arg( metrics.readSeconds, 0, 'f', 2 );
+      QMessageBox::information(
+          win,
+          QObject::tr( "Model load" ),
+          QObject::tr( "%1: Loaded model: %2 (%3, optimized in %4 s, "
+                       "%5 drawables)" )
+              .arg( QString::fromStdString( timestamp ) )
+              .arg( qfilename )
+              .arg( source )
+              .arg( metrics.optimizeSeconds, 0, 'f', 2 )
+              .arg( qulonglong( metrics.drawables ) ) );
+    }
+    else if ( metrics.cancelled ) {
+      win->statusBar()->showMessage(
+          QObject::tr( "Cancelled loading: %1" ).arg( qfilename ), 5000 );
     }
     else {
       QMessageBox::warning( win,
@@ -30,6 +51,14 @@ main( int argc, char ** argv )
                                 .arg( qfilename ) );
     }
   } );
+  window.modelLoadProgress.connect( [win = &window]( qtosgboost::LoadId,
+                                                     std::string const & filename,
+                                                     double progress ) {
+    win->statusBar()->showMessage(
+        QObject::tr( "Loading %1: %2%" )
+            .arg( QString::fromStdString( filename ) )
+            .arg( int( progress * 100.0 ) ) );
+  } );
   window.show();
 
   return qapp.exec();